@@ -0,0 +1,570 @@
+#ifndef STREAM_ALIGNER_ASYNC_STREAM_ALIGNER_HPP
+#define STREAM_ALIGNER_ASYNC_STREAM_ALIGNER_HPP
+
+#include <stream_aligner/StreamAligner.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace stream_aligner
+{
+    /**
+     * AsyncStreamAligner
+     *
+     * @brief StreamAligner which releases the samples from its own thread
+     *
+     * The worker thread sleeps until new data is pushed, or until the
+     * timeout of a stream waiting for data expires, and then gives all the
+     * samples which can be released to their callbacks. There is no need to
+     * call step() anymore.
+     *
+     * The timeout runs on a monotonic clock (std::chrono::steady_clock),
+     * so that steps of the wall clock have no effect: the data time is
+     * assumed to go on at the pace of that clock from the last time it
+     * advanced, and the streams waiting for data time out once the timeout
+     * elapsed that way. The samples are then released by advancing the data
+     * time to the timeout of the waiting streams, so that the timestamps of
+     * the samples do not need to be comparable to base::Time::now().
+     *
+     * All methods are thread-safe. The callbacks are called from the worker
+     * thread with the aligner locked, they must not call back into the
+     * aligner.
+     *
+     * */
+    template<size_t NUMBER_STREAMS>
+    class AsyncStreamAligner : protected StreamAligner<NUMBER_STREAMS>
+    {
+    protected:
+        typedef StreamAligner<NUMBER_STREAMS> Base;
+
+        /** clock of the deadlines of the worker. Monotonic, so that a step
+         * of the wall clock does not make it oversleep or release early **/
+        typedef std::chrono::steady_clock clock;
+
+        /** protects the aligner state **/
+        mutable std::mutex mutex;
+
+        /** protects wakeup and stopping. Never held while the callbacks
+         * run, so that pushing never waits on the worker **/
+        std::mutex wakeup_mutex;
+        std::condition_variable wakeup_cond;
+        bool wakeup;
+        bool stopping;
+
+        std::thread worker;
+
+        /** latest time of the aligner, and the time it was reached at,
+         * from which the timeout runs **/
+        base::Time progress_data_time;
+        clock::time_point progress_wall_time;
+
+        /** minimum time between two publications of the status **/
+        base::Time publish_period;
+        clock::time_point next_publish;
+
+        static clock::duration toDuration(const base::Time &time)
+        {
+            return std::chrono::duration_cast<clock::duration>(std::chrono::microseconds(time.toMicroseconds()));
+        }
+
+    protected:
+        /** Wakes the worker up after new data got pushed */
+        void notify()
+        {
+            {
+                std::lock_guard<std::mutex> lock(wakeup_mutex);
+                wakeup = true;
+            }
+            wakeup_cond.notify_one();
+        }
+
+        /** Releases all the samples that can be released
+         *
+         * @param deadline - set to the time at which the streams waiting for
+         * data time out
+         * @return false if no sample is waiting for release
+         */
+        bool releaseAll(clock::time_point &deadline)
+        {
+            bool advanced = false;
+            while(true)
+            {
+                size_t released = Base::drain();
+
+                /** released everything **/
+                base::Time release_time = Base::nextReleaseTime();
+                if(release_time == base::Time::max())
+                    return false;
+
+                clock::time_point now = clock::now();
+                base::Time latest = Base::getLatestTime();
+                if(latest != progress_data_time)
+                {
+                    progress_data_time = latest;
+                    progress_wall_time = now;
+                }
+
+                /** blocked by a stream waiting for data **/
+                deadline = progress_wall_time + toDuration(release_time - latest);
+                if(now < deadline)
+                    return true;
+
+                /** samples held back in the queues of full streams, only a
+                 * push can make progress **/
+                if(advanced && !released)
+                    return false;
+
+                /** the streams waiting for data timed out **/
+                Base::advanceTime(release_time);
+                advanced = true;
+            }
+        }
+
+        /** Publishes the status if the publication period elapsed
+         *
+         * @return the time of the publication still to come, max if there
+         * is none
+         */
+        clock::time_point publish()
+        {
+            if(!Base::getStatusPublisher())
+                return clock::time_point::max();
+
+            clock::time_point now = clock::now();
+            if(now < next_publish)
+                return next_publish;
+
+            Base::publishStatus();
+            next_publish = now + toDuration(publish_period);
+            return clock::time_point::max();
+        }
+
+        /** Releases all the samples that can be released, and publishes
+         * the status
+         *
+         * @param deadline - set to the time at which the worker has to wake
+         * up: streams waiting for data time out, or the status is due
+         * @return false if the worker can wait for new data
+         */
+        bool dispatch(clock::time_point &deadline)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            bool waiting = releaseAll(deadline);
+
+            clock::time_point publication = publish();
+            if(publication != clock::time_point::max() && (!waiting || publication < deadline))
+            {
+                deadline = publication;
+                waiting = true;
+            }
+            return waiting;
+        }
+
+        void run()
+        {
+            while(true)
+            {
+                clock::time_point deadline;
+                bool waiting = dispatch(deadline);
+
+                std::unique_lock<std::mutex> lock(wakeup_mutex);
+                if(waiting)
+                {
+                    wakeup_cond.wait_until(lock, deadline, [this]() { return wakeup || stopping; });
+                }
+                else
+                {
+                    wakeup_cond.wait(lock, [this]() { return wakeup || stopping; });
+                }
+
+                if(stopping)
+                    return;
+                wakeup = false;
+            }
+        }
+
+    public:
+        /** Constructor. The worker thread is started by start()
+         */
+        explicit AsyncStreamAligner(base::Time timeout = base::Time::fromSeconds(1))
+            : Base(timeout), wakeup(false), stopping(false)
+        {
+        }
+
+        ~AsyncStreamAligner()
+        {
+            stop();
+        }
+
+        /** Starts the worker thread
+         */
+        void start()
+        {
+            if(worker.joinable())
+                throw std::runtime_error("AsyncStreamAligner already started");
+
+            {
+                std::lock_guard<std::mutex> lock(wakeup_mutex);
+                wakeup = true;
+                stopping = false;
+            }
+            worker = std::thread(&AsyncStreamAligner::run, this);
+        }
+
+        /** Stops the worker thread. Samples which have not been released yet
+         * stay in the streams
+         */
+        void stop()
+        {
+            if(!worker.joinable())
+                return;
+
+            {
+                std::lock_guard<std::mutex> lock(wakeup_mutex);
+                stopping = true;
+            }
+            wakeup_cond.notify_one();
+            worker.join();
+        }
+
+        /** @return true if the worker thread is running */
+        bool isRunning() const
+        {
+            return worker.joinable();
+        }
+
+        /** @see StreamAligner::setTimeout */
+        void setTimeout(const base::Time &t)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                Base::setTimeout(t);
+            }
+            notify();
+        }
+
+        /** @see StreamAligner::checkBufferSizes */
+        void checkBufferSizes() const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Base::checkBufferSizes();
+        }
+
+        /** @see StreamAligner::getTimeOut */
+        base::Time getTimeOut() const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return Base::getTimeOut();
+        }
+
+        /** @see StreamAligner::disableStream */
+        void disableStream(int idx)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                Base::disableStream(idx);
+            }
+            notify();
+        }
+
+        /** @see StreamAligner::enableStream */
+        void enableStream(int idx)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Base::enableStream(idx);
+        }
+
+        /** @see StreamAligner::isStreamActive */
+        bool isStreamActive(int idx) const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return Base::isStreamActive(idx);
+        }
+
+        /** @see StreamAligner::setReorderWindow */
+        void setReorderWindow(int idx, const base::Time &window)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Base::setReorderWindow(idx, window);
+        }
+
+        /** @see StreamAligner::setDecimation */
+        void setDecimation(int idx, size_t keep_every)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Base::setDecimation(idx, keep_every);
+        }
+
+        /** @see StreamAligner::setRateLimit */
+        void setRateLimit(int idx, const base::Time &min_interval)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Base::setRateLimit(idx, min_interval);
+        }
+
+        /** @see StreamAligner::enableLatencyHistogram */
+        void enableLatencyHistogram(int idx)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Base::enableLatencyHistogram(idx);
+        }
+
+        /** @see StreamAligner::disableLatencyHistogram */
+        void disableLatencyHistogram(int idx)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Base::disableLatencyHistogram(idx);
+        }
+
+        /** @return a copy of the histogram, @see StreamAligner::getLatencyHistogram
+         * @throw std::runtime_error if it is not enabled */
+        LatencyHistogram getLatencyHistogram(int idx) const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const LatencyHistogram *histogram = Base::getLatencyHistogram(idx);
+            if(!histogram)
+                throw std::runtime_error("latency histogram not enabled.");
+            return *histogram;
+        }
+
+        /** @see StreamAligner::setRecorder
+         *
+         * The times the worker releases samples at are recorded as well, so
+         * that replaying the log in a StreamAligner gives the same output.
+         */
+        void setRecorder(StreamRecorder *recorder)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Base::setRecorder(recorder);
+        }
+
+        /** @see StreamAligner::setStatusPublisher
+         *
+         * The worker thread publishes the status after releasing samples,
+         * at most once per period, and publishes the last changes once the
+         * period elapsed.
+         */
+        void setStatusPublisher(StatusPublisher<NUMBER_STREAMS> *publisher, const base::Time &period = base::Time::fromMilliseconds(100))
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Base::setStatusPublisher(publisher);
+            publish_period = period;
+            next_publish = clock::time_point();
+        }
+
+        /** @see StreamAligner::enableSpill */
+        void enableSpill(int idx, const std::string &directory, size_t max_size = size_t(1) << 30)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Base::enableSpill(idx, directory, max_size);
+        }
+
+        /** @see StreamAligner::disableSpill */
+        void disableSpill(int idx)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Base::disableSpill(idx);
+        }
+
+        /** @see StreamAligner::setOverflowPolicy */
+        void setOverflowPolicy(int idx, OverflowPolicy policy, const base::Time &block_timeout = base::Time())
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Base::setOverflowPolicy(idx, policy, block_timeout);
+        }
+
+        /** @see StreamAligner::setBufferPool */
+        void setBufferPool(size_t chunk_size, size_t max_chunks)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Base::setBufferPool(chunk_size, max_chunks);
+        }
+
+        /** @see StreamAligner::enableBufferGrowth */
+        void enableBufferGrowth(int idx)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Base::enableBufferGrowth(idx);
+        }
+
+        /** @see StreamAligner::disableBufferGrowth */
+        void disableBufferGrowth(int idx)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Base::disableBufferGrowth(idx);
+        }
+
+        /** @see StreamAligner::unregisterStream */
+        void unregisterStream(int idx)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                Base::unregisterStream(idx);
+            }
+            notify();
+        }
+
+        /** @see StreamAligner::registerStream */
+        template <class T, size_t BUFFER_SIZE> int registerStream( typename Stream<T, BUFFER_SIZE>::callback_t callback, base::Time period, int priority  = -1, const std::string &name = std::string())
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return Base::template registerStream<T, BUFFER_SIZE>(callback, period, priority, name);
+        }
+
+        /** @see StreamAligner::registerStreamHandle */
+        template <class T, size_t BUFFER_SIZE> StreamHandle<T, BUFFER_SIZE> registerStreamHandle( typename Stream<T, BUFFER_SIZE>::callback_t callback, base::Time period, int priority  = -1, const std::string &name = std::string())
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return Base::template registerStreamHandle<T, BUFFER_SIZE>(callback, period, priority, name);
+        }
+
+        /** @see StreamAligner::registerConcurrentStream */
+        template <class T, size_t BUFFER_SIZE, size_t QUEUE_SIZE> ConcurrentStreamHandle<T, BUFFER_SIZE, QUEUE_SIZE> registerConcurrentStream( typename Stream<T, BUFFER_SIZE>::callback_t callback, base::Time period, int priority  = -1, const std::string &name = std::string())
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return Base::template registerConcurrentStream<T, BUFFER_SIZE, QUEUE_SIZE>(callback, period, priority, name);
+        }
+
+        /** @see StreamAligner::registerSynchronizer */
+        template <size_t SYNC_BUFFER_SIZE, class... T, size_t... BUFFER_SIZE> Synchronizer<SYNC_BUFFER_SIZE, T...> *registerSynchronizer( typename Synchronizer<SYNC_BUFFER_SIZE, T...>::callback_t callback, const base::Time &tolerance, const StreamHandle<T, BUFFER_SIZE>&... handles )
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return Base::template registerSynchronizer<SYNC_BUFFER_SIZE>(callback, tolerance, handles...);
+        }
+
+        /** @brief Push new data into a concurrent stream
+         *
+         * Does not lock the aligner, the sample is queued and the worker
+         * woken up. @see StreamAligner::pushConcurrent
+         */
+        template <class T, size_t BUFFER_SIZE, size_t QUEUE_SIZE, class Data> bool pushConcurrent( const ConcurrentStreamHandle<T, BUFFER_SIZE, QUEUE_SIZE> &handle, const base::Time &ts, Data&& data )
+        {
+            bool queued = Base::pushConcurrent(handle, ts, std::forward<Data>(data));
+            notify();
+            return queued;
+        }
+
+        /** @see StreamAligner::push */
+        template <class T, size_t BUFFER_SIZE> void push( int idx, const base::Time &ts, const T& data )
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                Base::template push<T, BUFFER_SIZE>(idx, ts, data);
+            }
+            notify();
+        }
+
+        /** @overload */
+        template <class T, size_t BUFFER_SIZE> void push( int idx, const base::Time &ts, T&& data )
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                Base::template push<T, BUFFER_SIZE>(idx, ts, std::move(data));
+            }
+            notify();
+        }
+
+        /** @overload */
+        template <class T, size_t BUFFER_SIZE> void push( const StreamHandle<T, BUFFER_SIZE> &handle, const base::Time &ts, const typename StreamHandle<T, BUFFER_SIZE>::value_type& data )
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                Base::push(handle, ts, data);
+            }
+            notify();
+        }
+
+        /** @overload */
+        template <class T, size_t BUFFER_SIZE> void push( const StreamHandle<T, BUFFER_SIZE> &handle, const base::Time &ts, typename StreamHandle<T, BUFFER_SIZE>::value_type&& data )
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                Base::push(handle, ts, std::move(data));
+            }
+            notify();
+        }
+
+        /** @see StreamAligner::emplace */
+        template <class T, size_t BUFFER_SIZE, class... Args> void emplace( int idx, const base::Time &ts, Args&&... args )
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                Base::template emplace<T, BUFFER_SIZE>(idx, ts, std::forward<Args>(args)...);
+            }
+            notify();
+        }
+
+        /** @overload */
+        template <class T, size_t BUFFER_SIZE, class... Args> void emplace( const StreamHandle<T, BUFFER_SIZE> &handle, const base::Time &ts, Args&&... args )
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                Base::emplace(handle, ts, std::forward<Args>(args)...);
+            }
+            notify();
+        }
+
+        /** @see StreamAligner::clear */
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Base::clear();
+        }
+
+        /** @see StreamAligner::isReady */
+        bool isReady() const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return Base::isReady();
+        }
+
+        /** @see StreamAligner::nextReleaseTime */
+        base::Time nextReleaseTime() const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return Base::nextReleaseTime();
+        }
+
+        /** @see StreamAligner::getLatency */
+        base::Time getLatency() const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return Base::getLatency();
+        }
+
+        /** @see StreamAligner::getCurrentTime */
+        base::Time getCurrentTime() const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return Base::getCurrentTime();
+        }
+
+        /** @see StreamAligner::getLatestTime */
+        base::Time getLatestTime() const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return Base::getLatestTime();
+        }
+
+        /** @see StreamAligner::getStreamSize */
+        int getStreamSize() const { return Base::getStreamSize(); }
+
+        /** @return a copy of the buffer status of the stream */
+        StreamStatus getBufferStatus(int idx) const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return Base::getBufferStatus(idx);
+        }
+
+        /** @return a copy of the current status of the StreamAligner */
+        StreamAlignerStatus<NUMBER_STREAMS> getStatus() const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return Base::getStatus();
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef STREAM_ALIGNER_BUFFER_SIZE_HPP
+#define STREAM_ALIGNER_BUFFER_SIZE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace stream_aligner
+{
+    /** @brief Compile-time sizing of the stream buffers
+     *
+     *  While the aligner waits for a late stream, up to its timeout, the
+     *  other streams keep receiving samples which have to fit in their
+     *  buffer. A stream with period P receives timeout / P + 1 samples in
+     *  that time: buffers smaller than that drop samples when a stream
+     *  times out.
+     *
+     *  The durations are given in microseconds, as base::Time is not a
+     *  literal type. These functions take negative durations as their
+     *  absolute value. A null period is an aperiodic stream, which cannot
+     *  be sized from its period.
+     *
+     *      const size_t IMU_BUFFER = bufferSize(IMU_PERIOD_US, TIMEOUT_US);
+     *      static_assert(bufferSizeFits(CAMERA_BUFFER, CAMERA_PERIOD_US, TIMEOUT_US),
+     *              "camera buffer too small for the timeout");
+     */
+
+    constexpr int64_t absoluteDuration(int64_t duration_us)
+    {
+        return duration_us < 0 ? -duration_us : duration_us;
+    }
+
+    /** @return the number of samples of a stream with the given period which
+     * arrive during the timeout, 0 for an aperiodic stream */
+    constexpr size_t samplesInTimeout(int64_t period_us, int64_t timeout_us)
+    {
+        return period_us == 0 ? 0 : size_t(absoluteDuration(timeout_us) / absoluteDuration(period_us)) + 1;
+    }
+
+    /** @return the buffer size of a stream with the given period, with
+     * safety_percent percent of the samples arriving during the timeout. The
+     * default leaves room for two timeouts */
+    constexpr size_t bufferSize(int64_t period_us, int64_t timeout_us, unsigned safety_percent = 200)
+    {
+        return (samplesInTimeout(period_us, timeout_us) * safety_percent + 99) / 100;
+    }
+
+    /** @return true if a buffer of buffer_size samples holds the samples a
+     * stream with the given period receives during the timeout */
+    constexpr bool bufferSizeFits(size_t buffer_size, int64_t period_us, int64_t timeout_us)
+    {
+        return buffer_size >= samplesInTimeout(period_us, timeout_us);
+    }
+}
+#endif
@@ -0,0 +1,385 @@
+#ifndef STREAM_ALIGNER_CHUNK_POOL_HPP
+#define STREAM_ALIGNER_CHUNK_POOL_HPP
+
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+namespace stream_aligner
+{
+    /** @brief ChunkPool
+     *
+     *  Pool of fixed-size memory chunks, shared by the growable buffers of
+     *  the streams of an aligner. Chunks are allocated on demand, up to
+     *  max_chunks, and kept in the pool when they are given back, so that a
+     *  stream which falls behind again does not allocate anymore.
+     *
+     *  The pool is not thread-safe, it has to be used from the thread running
+     *  the aligner.
+     */
+    class ChunkPool
+    {
+    protected:
+        /** free chunks, linked through their first bytes **/
+        struct FreeChunk
+        {
+            FreeChunk *next;
+        };
+
+        size_t chunk_size;
+        size_t max_chunks;
+
+        /** chunks allocated from the heap **/
+        size_t chunks_allocated;
+
+        /** chunks handed out and not given back **/
+        size_t chunks_used;
+
+        FreeChunk *free_chunks;
+
+    public:
+        /** @brief Constructor
+         *
+         *  @param chunk_size size of a chunk in bytes
+         *  @param max_chunks maximum number of chunks allocated by the pool
+         */
+        explicit ChunkPool(size_t chunk_size = 4096, size_t max_chunks = 256)
+            : chunk_size(0), max_chunks(0), chunks_allocated(0), chunks_used(0), free_chunks(NULL)
+        {
+            this->configure(chunk_size, max_chunks);
+        }
+
+        ~ChunkPool()
+        {
+            this->trim();
+        }
+
+        /** @brief change the chunk size and the limit
+         *
+         *  @throw std::runtime_error if chunks are in use
+         */
+        void configure(size_t chunk_size, size_t max_chunks)
+        {
+            if (this->chunks_used)
+                throw std::runtime_error("cannot configure a chunk pool in use");
+            if (chunk_size < sizeof(FreeChunk))
+                throw std::runtime_error("chunk size too small");
+
+            this->trim();
+            this->chunk_size = chunk_size;
+            this->max_chunks = max_chunks;
+        }
+
+        /** @brief take a chunk from the pool
+         *
+         *  @return the chunk, NULL if max_chunks chunks are in use
+         */
+        void* allocate()
+        {
+            if (this->free_chunks)
+            {
+                FreeChunk *chunk = this->free_chunks;
+                this->free_chunks = chunk->next;
+                this->chunks_used++;
+                return chunk;
+            }
+
+            if (this->chunks_allocated == this->max_chunks)
+                return NULL;
+
+            void *chunk = ::operator new(this->chunk_size);
+            this->chunks_allocated++;
+            this->chunks_used++;
+            return chunk;
+        }
+
+        /** @brief give a chunk back to the pool
+         */
+        void deallocate(void *chunk)
+        {
+            FreeChunk *free_chunk = static_cast<FreeChunk*>(chunk);
+            free_chunk->next = this->free_chunks;
+            this->free_chunks = free_chunk;
+            this->chunks_used--;
+        }
+
+        /** @brief release the unused chunks to the heap
+         */
+        void trim()
+        {
+            while (this->free_chunks)
+            {
+                FreeChunk *chunk = this->free_chunks;
+                this->free_chunks = chunk->next;
+                ::operator delete(chunk);
+                this->chunks_allocated--;
+            }
+        }
+
+        size_t chunkSize() const { return this->chunk_size; }
+        size_t maxChunks() const { return this->max_chunks; }
+        size_t chunksAllocated() const { return this->chunks_allocated; }
+        size_t chunksUsed() const { return this->chunks_used; }
+    };
+
+    /** @brief ChunkQueue
+     *
+     *  FIFO queue storing its elements in chunks taken from a ChunkPool.
+     *  A chunk is taken when the last one is full and given back as soon as
+     *  all its elements got removed, so that the memory used follows the
+     *  number of elements.
+     */
+    template <class T>
+    class ChunkQueue
+    {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "ChunkQueue element alignment not supported");
+
+    protected:
+        struct Chunk
+        {
+            Chunk *next;
+        };
+
+        ChunkPool *pool;
+
+        /** oldest and newest chunks **/
+        Chunk *head, *tail;
+
+        /** first element in the head chunk, past the last element in the
+         * tail chunk **/
+        size_t head_idx, tail_idx;
+
+        size_t elements_count;
+        size_t chunks_count;
+
+        /** number of elements in a chunk. Set when the first chunk is
+         * taken, as the pool may be reconfigured while the queue is empty **/
+        size_t chunk_capacity;
+
+        static size_t elementsOffset()
+        {
+            return (sizeof(Chunk) + alignof(T) - 1) / alignof(T) * alignof(T);
+        }
+
+        static T* elements(Chunk *chunk)
+        {
+            return reinterpret_cast<T*>(reinterpret_cast<char*>(chunk) + elementsOffset());
+        }
+
+        static const T* elements(const Chunk *chunk)
+        {
+            return reinterpret_cast<const T*>(reinterpret_cast<const char*>(chunk) + elementsOffset());
+        }
+
+        /** @return the number of elements in a chunk of the given pool, 0
+         * if an element does not fit */
+        static size_t chunkCapacity(const ChunkPool &pool)
+        {
+            if (pool.chunkSize() <= elementsOffset())
+                return 0;
+            return (pool.chunkSize() - elementsOffset()) / sizeof(T);
+        }
+
+    public:
+        ChunkQueue()
+            : pool(NULL), head(NULL), tail(NULL), head_idx(0), tail_idx(0),
+              elements_count(0), chunks_count(0), chunk_capacity(0)
+        {
+        }
+
+        ChunkQueue(const ChunkQueue &other) = delete;
+
+        ~ChunkQueue()
+        {
+            this->clear();
+        }
+
+        /** @brief copy the elements of another queue
+         *
+         *  The chunks are taken from the pool of this queue.
+         *
+         *  @throw std::runtime_error if the elements do not fit in the pool
+         */
+        ChunkQueue& operator=(const ChunkQueue &other)
+        {
+            if (this == &other)
+                return *this;
+
+            this->clear();
+            for (const Chunk *chunk = other.head; chunk; chunk = chunk->next)
+            {
+                size_t begin = (chunk == other.head) ? other.head_idx : 0;
+                size_t end = (chunk == other.tail) ? other.tail_idx : other.chunk_capacity;
+                for (size_t i = begin; i < end; ++i)
+                {
+                    if (!this->emplace_back(elements(chunk)[i]))
+                        throw std::runtime_error("chunk pool exhausted while copying a queue");
+                }
+            }
+            return *this;
+        }
+
+        /** @brief set the pool the chunks are taken from
+         *
+         *  @throw std::runtime_error if the queue is not empty, or if an
+         *  element does not fit in a chunk
+         */
+        void setPool(ChunkPool *pool)
+        {
+            if (!this->empty())
+            {
+                if (pool == this->pool)
+                    return;
+                throw std::runtime_error("cannot change the pool of a non-empty queue");
+            }
+
+            size_t capacity = 0;
+            if (pool)
+            {
+                capacity = chunkCapacity(*pool);
+                if (capacity == 0)
+                    throw std::runtime_error("chunk size too small for the queue elements");
+            }
+
+            this->pool = pool;
+            this->chunk_capacity = capacity;
+        }
+
+        /** @brief construct an element at the back
+         *
+         *  @param args the constructor arguments of the element.
+         *  @return false if no chunk could be taken from the pool. Nothing
+         *  is constructed in that case.
+         */
+        template <class... Args>
+        bool emplace_back(Args&&... args)
+        {
+            if (!this->tail || this->tail_idx == this->chunk_capacity)
+            {
+                if (!this->pool)
+                    return false;
+
+                /** the pool cannot be reconfigured while it holds chunks of
+                 * this queue, only the first chunk may differ **/
+                if (!this->tail)
+                {
+                    this->chunk_capacity = chunkCapacity(*this->pool);
+                    if (this->chunk_capacity == 0)
+                        return false;
+                }
+
+                Chunk *chunk = static_cast<Chunk*>(this->pool->allocate());
+                if (!chunk)
+                    return false;
+
+                chunk->next = NULL;
+                if (this->tail)
+                    this->tail->next = chunk;
+                else
+                    this->head = chunk;
+                this->tail = chunk;
+                this->tail_idx = 0;
+                this->chunks_count++;
+            }
+
+            new (elements(this->tail) + this->tail_idx) T(std::forward<Args>(args)...);
+            this->tail_idx++;
+            this->elements_count++;
+            return true;
+        }
+
+        /** @brief front
+         *
+         *  @return the oldest element. The queue must not be empty
+         */
+        T& front()
+        {
+            return elements(this->head)[this->head_idx];
+        }
+
+        const T& front() const
+        {
+            return elements(this->head)[this->head_idx];
+        }
+
+        /** @brief element access
+         *
+         *  Walks the chunks up to the element, in O(i / elements per chunk).
+         *
+         *  @param i position from the front, lower than size()
+         *  @return reference to the element
+         */
+        T& at(size_t i)
+        {
+            size_t pos = this->head_idx + i;
+            Chunk *chunk = this->head;
+            for (; pos >= this->chunk_capacity; pos -= this->chunk_capacity)
+                chunk = chunk->next;
+            return elements(chunk)[pos];
+        }
+
+        /** @brief remove the oldest element
+         *
+         *  Its chunk is given back to the pool if it was the last element of
+         *  the chunk. The queue must not be empty
+         */
+        void pop_front()
+        {
+            elements(this->head)[this->head_idx].~T();
+            this->head_idx++;
+            this->elements_count--;
+
+            if (this->elements_count == 0 || this->head_idx == this->chunk_capacity)
+            {
+                Chunk *chunk = this->head;
+                this->head = chunk->next;
+                this->head_idx = 0;
+                if (!this->head)
+                {
+                    this->tail = NULL;
+                    this->tail_idx = 0;
+                }
+                this->pool->deallocate(chunk);
+                this->chunks_count--;
+            }
+        }
+
+        /** @brief remove all the elements and give the chunks back
+         */
+        void clear()
+        {
+            while (!this->empty())
+                this->pop_front();
+        }
+
+        bool empty() const
+        {
+            return this->elements_count == 0;
+        }
+
+        size_t size() const
+        {
+            return this->elements_count;
+        }
+
+        /** @return the pool the chunks are taken from, NULL if not set **/
+        const ChunkPool* getPool() const
+        {
+            return this->pool;
+        }
+
+        /** @return number of chunks taken from the pool **/
+        size_t chunks() const
+        {
+            return this->chunks_count;
+        }
+
+        /** @return number of elements the taken chunks are able to hold **/
+        size_t capacity() const
+        {
+            return this->chunks_count * this->chunk_capacity;
+        }
+    };
+}
+#endif
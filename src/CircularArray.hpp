@@ -2,6 +2,9 @@
 #define STREAM_ALIGNER_CIRCULAR_ARRAY_HPP
 
 #include <array>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <iostream>
 #include <base/Float.hpp>
 #include <base/Time.hpp>
@@ -18,6 +21,41 @@ namespace stream_aligner
         int front_idx, rear_idx;
         size_t elements_count;
 
+        /** @brief make room at the rear
+         *
+         *  Advances the rear index, overwriting the
+         *  front-most element if the array is full.
+         *
+         *  @return index of the new rear slot
+         */
+        int next_back()
+        {
+            if(this->full())
+            {
+                /** The buffer is full now, so pushing subsequent
+                 elements will overwrite the front-most elements. **/
+                if(front_idx==CircularArray::max_size-1)
+                    front_idx=0;
+                else
+                    front_idx++;
+
+                this->elements_count--;
+            }
+
+            if(rear_idx == -1)
+            {
+                rear_idx++;
+                front_idx++;
+            }
+            else if(rear_idx==CircularArray::max_size-1)
+                rear_idx=0;
+            else
+                rear_idx++;
+
+            this->elements_count++;
+            return rear_idx;
+        }
+
     public:
         /** @brief Constructor
          *
@@ -77,33 +115,41 @@ namespace stream_aligner
          */
         void push_back(const T &ts)
         {
-            if(this->full())
-            {
-                /** The buffer is full now, so pushing subsequent
-                 elements will overwrite the front-most elements. **/
-                if(front_idx==CircularArray::max_size-1)
-                    front_idx=0;
-                else
-                    front_idx++;
-
-                this->elements_count--;
-            }
+            data[this->next_back()] = ts;
+            //std::cout<<"["<<rear_idx<<"]"<<data[rear_idx]<<" back inserted"<<std::endl;
+            return;
 
-            if(rear_idx == -1)
-            {
-                rear_idx++;
-                front_idx++;
-            }
-            else if(rear_idx==CircularArray::max_size-1)
-                rear_idx=0;
-            else
-                rear_idx++;
+        };
 
-            data[rear_idx] = ts;
-            this->elements_count++;
-            //std::cout<<"["<<rear_idx<<"]"<<data[rear_idx]<<" back inserted"<<std::endl;
+        /** @brief insert an element
+         *
+         *  This methods moves a new element
+         *  at the rear of the CircularArray
+         *
+         *  @param ts the element.
+         *  @return void.
+         */
+        void push_back(T &&ts)
+        {
+            data[this->next_back()] = std::move(ts);
             return;
+        };
 
+        /** @brief construct an element
+         *
+         *  This methods constructs a new element from
+         *  the given arguments and moves it into the slot
+         *  at the rear of the CircularArray
+         *
+         *  @param args the constructor arguments of the element.
+         *  @return the inserted element.
+         */
+        template <class... Args>
+        T& emplace_back(Args&&... args)
+        {
+            T &slot = data[this->next_back()];
+            slot = T(std::forward<Args>(args)...);
+            return slot;
         };
 
         /** @brief remove an element
@@ -112,19 +158,17 @@ namespace stream_aligner
          *  from the front of the CircularArray
          *
          *  @param void.
-         *  @return void.
+         *  @return the removed element, moved out of the array.
          */
         T pop_front()
         {
-            T ts =  base::NaN<T>(); 
-
             if(this->empty())
             {
-                return ts;
+                return base::NaN<T>();
             }
 
             //std::cout<<"["<<front_idx<<"]"<<data[front_idx]<<" front deleted"<<std::endl;
-            ts = data[front_idx];
+            T ts = std::move(data[front_idx]);
             this->elements_count--;
 
             if(front_idx==CircularArray::max_size-1)
@@ -135,6 +179,41 @@ namespace stream_aligner
             return ts;
         };
 
+        /** @brief consume an element
+         *
+         *  This methods calls the given function on the
+         *  front element, in place, and then removes it
+         *  from the CircularArray. The removed slot is reset
+         *  to a default constructed element so that its
+         *  resources are released, unless T holds none
+         *  (trivially destructible), so that large plain
+         *  payloads are not rewritten.
+         *
+         *  @param f function called as f(T&).
+         *  @return false if the array was empty.
+         */
+        template <class F>
+        bool consume_front(F f)
+        {
+            if(this->empty())
+            {
+                return false;
+            }
+
+            f(data[front_idx]);
+
+            if(!std::is_trivially_destructible<T>::value)
+                data[front_idx] = T();
+            this->elements_count--;
+
+            if(front_idx==CircularArray::max_size-1)
+                front_idx=0;
+            else
+                front_idx++;
+
+            return true;
+        };
+
         /** @brief remove an element
          *
          *  This methods remove an element
@@ -153,7 +232,7 @@ namespace stream_aligner
             }
 
             //std::cout<<"["<<rear_idx<<"]"<<data[rear_idx]<<" back deleted"<<std::endl;
-            ts = data[rear_idx];
+            ts = std::move(data[rear_idx]);
             this->elements_count--;
 
             if(rear_idx==0)
@@ -167,18 +246,46 @@ namespace stream_aligner
         /** @brief front
          *
          * It gives the front element without
-         * removing it from the array
+         * removing it from the array.
          *
          *  @param void.
-         *  @return the first element
+         *  @return reference to the first element
+         *  @throw std::runtime_error if the array is empty
          */
-        T front() const
+        T& front()
+        {
+            if(this->empty())
+            {
+                throw std::runtime_error("front of an empty circular array.");
+            }
+            return data[front_idx];
+        }
+
+        const T& front() const
         {
-            if(!this->empty())
+            if(this->empty())
             {
-                return data[front_idx];
+                throw std::runtime_error("front of an empty circular array.");
             }
-            return base::NaN<T>();
+            return data[front_idx];
+        }
+
+        /** @brief element access
+         *
+         * It gives the element at the given position,
+         * counted from the front of the array.
+         *
+         *  @param i position, lower than size().
+         *  @return reference to the element
+         */
+        T& at(size_t i)
+        {
+            return data[(front_idx + i) % CircularArray::max_size];
+        }
+
+        const T& at(size_t i) const
+        {
+            return data[(front_idx + i) % CircularArray::max_size];
         }
 
         /** begin
@@ -188,6 +295,7 @@ namespace stream_aligner
          * @return pointer to the last element
          */
         T* begin (){return std::__addressof(data[front_idx]);}
+        const T* begin () const {return std::__addressof(data[front_idx]);}
 
        /** rend
         *
@@ -217,18 +325,28 @@ namespace stream_aligner
         /** @brief back
          *
          * It gives the last element without
-         * removing it from the array
+         * removing it from the array.
          *
          *  @param void.
-         *  @return the last element
+         *  @return reference to the last element
+         *  @throw std::runtime_error if the array is empty
          */
-        T back() const
+        T& back()
         {
-            if(!this->empty())
+            if(this->empty())
+            {
+                throw std::runtime_error("back of an empty circular array.");
+            }
+            return data[rear_idx];
+        }
+
+        const T& back() const
+        {
+            if(this->empty())
             {
-                return data[rear_idx];
+                throw std::runtime_error("back of an empty circular array.");
             }
-            return base::NaN<T>();
+            return data[rear_idx];
         }
 
         /** end
@@ -0,0 +1,32 @@
+#ifndef STREAM_ALIGNER_INDEX_SEQUENCE_HPP
+#define STREAM_ALIGNER_INDEX_SEQUENCE_HPP
+
+#include <cstddef>
+
+namespace stream_aligner
+{
+    /** @brief IndexSequence
+     *
+     *  Compile-time sequence of indices, used to expand a tuple or a
+     *  parameter pack along with the position of its elements (C++11
+     *  replacement of std::index_sequence).
+     */
+    template <size_t... I>
+    struct IndexSequence
+    {
+    };
+
+    /** @brief MakeIndexSequence<N>::type is IndexSequence<0, ..., N-1>
+     */
+    template <size_t N, size_t... I>
+    struct MakeIndexSequence : MakeIndexSequence<N - 1, N - 1, I...>
+    {
+    };
+
+    template <size_t... I>
+    struct MakeIndexSequence<0, I...>
+    {
+        typedef IndexSequence<I...> type;
+    };
+}
+#endif
@@ -0,0 +1,131 @@
+#ifndef STREAM_ALIGNER_INGEST_QUEUE_HPP
+#define STREAM_ALIGNER_INGEST_QUEUE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <stdint.h>
+#include <utility>
+
+namespace stream_aligner
+{
+    /** @brief IngestQueue
+     *
+     *  Bounded lock-free queue for multiple producers and a single consumer.
+     *
+     *  Each slot carries a sequence number telling whether it is free for
+     *  the producer of a given round or filled for the consumer, so producers
+     *  only contend on the enqueue position and never wait on each other.
+     *  N has to be a power of two.
+     */
+    template <class T, size_t N>
+    class IngestQueue
+    {
+        static_assert(N >= 2 && (N & (N - 1)) == 0, "IngestQueue size must be a power of two");
+
+    protected:
+        struct Cell
+        {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        /** padding keeping the positions in separate cache lines. alignas
+         * is not used since C++11 operator new ignores extended alignment **/
+        static const size_t CACHE_LINE_SIZE = 64;
+
+        std::array<Cell, N> cells;
+        char pad0[CACHE_LINE_SIZE];
+
+        /** written by the producers **/
+        std::atomic<size_t> enqueue_pos;
+        char pad1[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+
+        /** written by the consumer only **/
+        std::atomic<size_t> dequeue_pos;
+
+    public:
+        IngestQueue()
+        {
+            for (size_t i = 0; i < N; ++i)
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+            enqueue_pos.store(0, std::memory_order_relaxed);
+            dequeue_pos.store(0, std::memory_order_relaxed);
+        }
+
+        /** @brief insert an element (producer side)
+         *
+         *  Thread-safe and lock-free.
+         *
+         *  @param args the constructor arguments of the element.
+         *  @return false if the queue is full.
+         */
+        template <class... Args>
+        bool push(Args&&... args)
+        {
+            Cell *cell;
+            size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+            while (true)
+            {
+                cell = &cells[pos & (N - 1)];
+                size_t seq = cell->sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+                if (diff == 0)
+                {
+                    if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                    return false;
+                else
+                    pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+
+            cell->value = T(std::forward<Args>(args)...);
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** @brief remove an element (consumer side)
+         *
+         *  Must only be called from a single thread.
+         *
+         *  @param value set to the removed element.
+         *  @return false if the queue is empty.
+         */
+        bool pop(T &value)
+        {
+            size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+            Cell &cell(cells[pos & (N - 1)]);
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) < 0)
+                return false;
+
+            value = std::move(cell.value);
+            cell.sequence.store(pos + N, std::memory_order_release);
+            dequeue_pos.store(pos + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        /** @brief approximate number of elements in the queue
+         *
+         *  Exact when called from the consumer while no producer is active.
+         */
+        size_t size() const
+        {
+            size_t enqueued = enqueue_pos.load(std::memory_order_relaxed);
+            size_t dequeued = dequeue_pos.load(std::memory_order_relaxed);
+            return enqueued > dequeued ? enqueued - dequeued : 0;
+        }
+
+        /** @brief capacity
+         *
+         *  @return maximum number of elements the queue is able to hold
+         */
+        size_t capacity() const
+        {
+            return N;
+        }
+    };
+}
+#endif
@@ -0,0 +1,181 @@
+#ifndef STREAM_ALIGNER_INPLACE_FUNCTION_HPP
+#define STREAM_ALIGNER_INPLACE_FUNCTION_HPP
+
+#include <boost/function.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace stream_aligner
+{
+    template <class Signature, size_t STORAGE_SIZE = 64>
+    class InplaceFunction;
+
+    /**
+     * InplaceFunction
+     *
+     * @brief Type-erased callable stored in a fixed-size buffer
+     *
+     * Drop-in replacement for boost::function which never allocates: the
+     * callable (function pointer, functor, lambda, bind expression or even a
+     * boost::function) is stored inside the object itself. Callables larger
+     * than STORAGE_SIZE are rejected at compile time.
+     *
+     * */
+    template <class R, class... Args, size_t STORAGE_SIZE>
+    class InplaceFunction<R (Args...), STORAGE_SIZE>
+    {
+    protected:
+        typedef typename std::aligned_storage<STORAGE_SIZE, alignof(std::max_align_t)>::type storage_t;
+
+        enum Operation { COPY, MOVE, DESTROY };
+
+        typedef R (*invoker_t)(storage_t &storage, Args... args);
+        typedef void (*manager_t)(Operation op, storage_t &dst, storage_t &src);
+
+        mutable storage_t storage;
+        invoker_t invoker;
+        manager_t manager;
+
+        template <class F>
+        static R invoke(storage_t &storage, Args... args)
+        {
+            return (*reinterpret_cast<F*>(&storage))(std::forward<Args>(args)...);
+        }
+
+        static R invokeEmpty(storage_t &, Args...)
+        {
+            throw std::bad_function_call();
+        }
+
+        template <class F>
+        static void manage(Operation op, storage_t &dst, storage_t &src)
+        {
+            switch(op)
+            {
+                case COPY:
+                    new (&dst) F(*reinterpret_cast<const F*>(&src));
+                    break;
+                case MOVE:
+                    new (&dst) F(std::move(*reinterpret_cast<F*>(&src)));
+                    reinterpret_cast<F*>(&src)->~F();
+                    break;
+                case DESTROY:
+                    reinterpret_cast<F*>(&dst)->~F();
+                    break;
+            }
+        }
+
+        /** callables which convert to an empty function **/
+        template <class F> static bool isEmpty(const F &) { return false; }
+        template <class P> static bool isEmpty(P *f) { return f == NULL; }
+        template <class S> static bool isEmpty(const boost::function<S> &f) { return f.empty(); }
+        template <class S> static bool isEmpty(const std::function<S> &f) { return !f; }
+
+        void reset()
+        {
+            if(manager)
+                manager(DESTROY, storage, storage);
+            invoker = &invokeEmpty;
+            manager = NULL;
+        }
+
+    public:
+        InplaceFunction() : invoker(&invokeEmpty), manager(NULL) {}
+
+        InplaceFunction(std::nullptr_t) : invoker(&invokeEmpty), manager(NULL) {}
+
+        template <class F, class = typename std::enable_if<
+            !std::is_same<typename std::decay<F>::type, InplaceFunction>::value>::type,
+            class = decltype(std::declval<typename std::decay<F>::type&>()(std::declval<Args>()...))>
+        InplaceFunction(F &&f) : invoker(&invokeEmpty), manager(NULL)
+        {
+            typedef typename std::decay<F>::type functor_t;
+            static_assert(sizeof(functor_t) <= STORAGE_SIZE,
+                    "callable too large for InplaceFunction, increase STORAGE_SIZE");
+            static_assert(alignof(functor_t) <= alignof(storage_t),
+                    "callable alignment not supported by InplaceFunction");
+
+            if(isEmpty(f))
+                return;
+
+            new (&storage) functor_t(std::forward<F>(f));
+            invoker = &invoke<functor_t>;
+            manager = &manage<functor_t>;
+        }
+
+        InplaceFunction(const InplaceFunction &other) : invoker(other.invoker), manager(other.manager)
+        {
+            if(manager)
+                manager(COPY, storage, other.storage);
+        }
+
+        InplaceFunction(InplaceFunction &&other) : invoker(other.invoker), manager(other.manager)
+        {
+            if(manager)
+                manager(MOVE, storage, other.storage);
+            other.invoker = &invokeEmpty;
+            other.manager = NULL;
+        }
+
+        ~InplaceFunction()
+        {
+            reset();
+        }
+
+        InplaceFunction& operator=(const InplaceFunction &other)
+        {
+            if(this != &other)
+            {
+                reset();
+                if(other.manager)
+                    other.manager(COPY, storage, other.storage);
+                invoker = other.invoker;
+                manager = other.manager;
+            }
+            return *this;
+        }
+
+        InplaceFunction& operator=(InplaceFunction &&other)
+        {
+            if(this != &other)
+            {
+                reset();
+                if(other.manager)
+                    other.manager(MOVE, storage, other.storage);
+                invoker = other.invoker;
+                manager = other.manager;
+                other.invoker = &invokeEmpty;
+                other.manager = NULL;
+            }
+            return *this;
+        }
+
+        InplaceFunction& operator=(std::nullptr_t)
+        {
+            reset();
+            return *this;
+        }
+
+        /** @return true if a callable is stored **/
+        explicit operator bool() const
+        {
+            return manager != NULL;
+        }
+
+        bool empty() const
+        {
+            return manager == NULL;
+        }
+
+        /** calls the stored callable. Throws std::bad_function_call if empty **/
+        R operator()(Args... args) const
+        {
+            return invoker(storage, std::forward<Args>(args)...);
+        }
+    };
+}
+#endif
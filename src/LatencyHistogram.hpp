@@ -0,0 +1,254 @@
+#ifndef STREAM_ALIGNER_LATENCY_HISTOGRAM_HPP
+#define STREAM_ALIGNER_LATENCY_HISTOGRAM_HPP
+
+#include <stream_aligner/ChunkPool.hpp>
+
+#include <base/Time.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace stream_aligner
+{
+    /** @brief LatencyHistogram
+     *
+     *  Histogram of durations in microseconds, with log-scale buckets: each
+     *  power of two is split in SUB_BUCKETS buckets, so that a value is
+     *  known within 1 / SUB_BUCKETS of itself. Durations up to 8 us are
+     *  counted exactly. The memory used is fixed, and adding a value does
+     *  not allocate.
+     */
+    class LatencyHistogram
+    {
+    public:
+        static const unsigned SUB_BUCKET_BITS = 3;
+        static const unsigned SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+
+        /** enough buckets for any positive int64 **/
+        static const unsigned BUCKETS = (64 - SUB_BUCKET_BITS) * SUB_BUCKETS;
+
+    protected:
+        uint64_t buckets[BUCKETS];
+        uint64_t samples;
+        int64_t sum, min_value, max_value;
+
+        static unsigned bucketIndex(int64_t value)
+        {
+            if (value < int64_t(SUB_BUCKETS))
+                return value;
+
+            unsigned exponent = 63 - __builtin_clzll(value);
+            unsigned shift = exponent - SUB_BUCKET_BITS;
+            return (shift + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1));
+        }
+
+        /** @return the highest value counted in the given bucket **/
+        static int64_t bucketUpperBound(unsigned idx)
+        {
+            if (idx < SUB_BUCKETS)
+                return idx;
+
+            unsigned shift = idx / SUB_BUCKETS - 1;
+            int64_t lower = int64_t(SUB_BUCKETS + idx % SUB_BUCKETS) << shift;
+            return lower + (int64_t(1) << shift) - 1;
+        }
+
+    public:
+        LatencyHistogram()
+        {
+            this->clear();
+        }
+
+        /** @brief counts a duration. Negative durations count as 0 */
+        void add(const base::Time &duration)
+        {
+            int64_t value = std::max<int64_t>(duration.toMicroseconds(), 0);
+            this->buckets[bucketIndex(value)]++;
+            this->sum += value;
+            if (!this->samples || value < this->min_value)
+                this->min_value = value;
+            if (!this->samples || value > this->max_value)
+                this->max_value = value;
+            this->samples++;
+        }
+
+        void clear()
+        {
+            std::fill(this->buckets, this->buckets + BUCKETS, 0);
+            this->samples = 0;
+            this->sum = this->min_value = this->max_value = 0;
+        }
+
+        /** @return the number of durations counted **/
+        uint64_t count() const { return this->samples; }
+
+        base::Time min() const { return base::Time::fromMicroseconds(this->min_value); }
+        base::Time max() const { return base::Time::fromMicroseconds(this->max_value); }
+
+        base::Time mean() const
+        {
+            return base::Time::fromMicroseconds(this->samples ? this->sum / int64_t(this->samples) : 0);
+        }
+
+        /** @brief percentile
+         *
+         *  @param p fraction of the durations, between 0 and 1
+         *  @return a duration which p of the counted durations do not
+         *  exceed, rounded up to the bucket precision. 0 if nothing was
+         *  counted.
+         */
+        base::Time percentile(double p) const
+        {
+            if (!this->samples)
+                return base::Time();
+
+            uint64_t rank = std::max<uint64_t>(1, uint64_t(p * this->samples + 0.5));
+            uint64_t cumulated = 0;
+            for (unsigned i = 0; i < BUCKETS; ++i)
+            {
+                cumulated += this->buckets[i];
+                if (cumulated >= rank)
+                    return base::Time::fromMicroseconds(std::min(bucketUpperBound(i), this->max_value));
+            }
+            return this->max();
+        }
+    };
+
+    /** @brief BufferLatency
+     *
+     *  Measures how long the samples of a stream stay in its buffer: the
+     *  times the stored samples were pushed at are kept in the order of the
+     *  samples, and the time spent in the buffer is counted in a
+     *  LatencyHistogram when a sample is released.
+     *
+     *  At most max_tracked push times are kept, in chunks of a private pool
+     *  bounded accordingly. When more samples are stored, e.g. in a spill
+     *  file, the oldest ones are released without being counted.
+     */
+    class BufferLatency
+    {
+    protected:
+        static const size_t CHUNK_SIZE = 4096;
+
+        ChunkPool pool;
+
+        /** push times of the stored samples, oldest sample first **/
+        ChunkQueue<int64_t> push_times;
+
+        /** oldest stored samples whose push time is not kept **/
+        size_t untracked;
+
+        size_t max_tracked;
+
+        LatencyHistogram histogram;
+
+        /** @return the number of chunks holding max_tracked push times,
+         * wherever the first one starts in its chunk **/
+        static size_t chunksFor(size_t max_tracked)
+        {
+            size_t per_chunk = (CHUNK_SIZE - sizeof(void*)) / sizeof(int64_t);
+            return (max_tracked + per_chunk - 1) / per_chunk + 1;
+        }
+
+    public:
+        /** @param max_tracked the number of samples the stream is able to
+         * store outside of a spill file */
+        explicit BufferLatency(size_t max_tracked)
+            : pool(CHUNK_SIZE, chunksFor(max_tracked)), untracked(0), max_tracked(max_tracked)
+        {
+            this->push_times.setPool(&this->pool);
+        }
+
+        /** @brief changes the number of push times kept
+         *
+         *  The samples stored so far are not counted anymore.
+         */
+        void setMaxTracked(size_t max_tracked)
+        {
+            this->untracked += this->push_times.size();
+            this->push_times.clear();
+            this->pool.configure(CHUNK_SIZE, chunksFor(max_tracked));
+            this->push_times.setPool(&this->pool);
+            this->max_tracked = max_tracked;
+        }
+
+        /** @brief a sample got stored at time now
+         *
+         *  @param stored the number of samples stored, including the new
+         *  one. The push times of the samples dropped to make room are
+         *  removed.
+         */
+        void pushed(const base::Time &now, size_t stored)
+        {
+            while (this->untracked + this->push_times.size() >= stored && this->untracked + this->push_times.size())
+            {
+                if (this->untracked)
+                    this->untracked--;
+                else
+                    this->push_times.pop_front();
+            }
+
+            if (this->push_times.size() >= this->max_tracked)
+            {
+                if (this->push_times.empty())
+                {
+                    this->untracked++;
+                    return;
+                }
+                this->push_times.pop_front();
+                this->untracked++;
+            }
+            this->push_times.emplace_back(now.toMicroseconds());
+        }
+
+        /** @brief the newest sample got moved to the given position */
+        void moved(size_t position)
+        {
+            if (this->push_times.empty())
+                return;
+
+            /** moved among the untracked samples: one of them gets tracked
+             * with its push time instead, which only shifts the times **/
+            size_t first = position < this->untracked ? 0 : position - this->untracked;
+            for (size_t i = this->push_times.size() - 1; i > first; --i)
+                std::swap(this->push_times.at(i), this->push_times.at(i - 1));
+        }
+
+        /** @brief the oldest sample got released at time now */
+        void released(const base::Time &now)
+        {
+            if (this->untracked)
+            {
+                this->untracked--;
+                return;
+            }
+            if (this->push_times.empty())
+                return;
+
+            this->histogram.add(now - base::Time::fromMicroseconds(this->push_times.front()));
+            this->push_times.pop_front();
+        }
+
+        /** @brief considers the stored samples as pushed at time now, when
+         * the samples were replaced */
+        void reset(const base::Time &now, size_t stored)
+        {
+            this->push_times.clear();
+            this->untracked = stored > this->max_tracked ? stored - this->max_tracked : 0;
+            for (size_t i = this->untracked; i < stored; ++i)
+                this->push_times.emplace_back(now.toMicroseconds());
+        }
+
+        /** @brief forgets the stored samples and the counted durations */
+        void clear()
+        {
+            this->push_times.clear();
+            this->untracked = 0;
+            this->histogram.clear();
+        }
+
+        const LatencyHistogram &getHistogram() const { return this->histogram; }
+    };
+}
+#endif
@@ -0,0 +1,76 @@
+#ifndef STREAM_ALIGNER_SAMPLE_SERIALIZER_HPP
+#define STREAM_ALIGNER_SAMPLE_SERIALIZER_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace stream_aligner
+{
+    /** @brief SampleSerializer
+     *
+     *  Converts the samples of a stream to bytes and back, for the spill
+     *  file and the recorder. Trivially copyable types are copied as they
+     *  are, and std::string is supported. Other types can be serialized by
+     *  specializing SampleSerializer<T> with the same members.
+     */
+    template <class T, bool = std::is_trivially_copyable<T>::value>
+    struct SampleSerializer
+    {
+        static const bool supported = true;
+
+        /** @return the number of bytes written by write() */
+        static size_t size(const T &)
+        {
+            return sizeof(T);
+        }
+
+        static void write(const T &value, char *data)
+        {
+            std::memcpy(data, &value, sizeof(T));
+        }
+
+        /** @throw std::runtime_error if size is not the size of T */
+        static void read(const char *data, size_t size, T &value)
+        {
+            if (size != sizeof(T))
+                throw std::runtime_error("serialized sample of the wrong size.");
+            std::memcpy(&value, data, sizeof(T));
+        }
+    };
+
+    /** types which cannot be serialized */
+    template <class T>
+    struct SampleSerializer<T, false>
+    {
+        static const bool supported = false;
+
+        static size_t size(const T &) { return 0; }
+        static void write(const T &, char *) {}
+        static void read(const char *, size_t, T &) {}
+    };
+
+    template <>
+    struct SampleSerializer<std::string, false>
+    {
+        static const bool supported = true;
+
+        static size_t size(const std::string &value)
+        {
+            return value.size();
+        }
+
+        static void write(const std::string &value, char *data)
+        {
+            value.copy(data, value.size());
+        }
+
+        static void read(const char *data, size_t size, std::string &value)
+        {
+            value.assign(data, size);
+        }
+    };
+}
+#endif
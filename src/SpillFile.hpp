@@ -0,0 +1,252 @@
+#ifndef STREAM_ALIGNER_SPILL_FILE_HPP
+#define STREAM_ALIGNER_SPILL_FILE_HPP
+
+#include <stream_aligner/SampleSerializer.hpp>
+
+#include <base/Time.hpp>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace stream_aligner
+{
+    /** @brief SpillFile
+     *
+     *  FIFO of timestamped samples stored in a memory-mapped append-only
+     *  file, so that a stream can keep more samples than fit in memory.
+     *  Samples are appended at the end of the file and read back from the
+     *  front. The file is rewound when it gets empty, and its live part is
+     *  moved back to the beginning instead of growing the file when more
+     *  than half of it has been read already.
+     *
+     *  The file is removed from the file system as soon as it is opened, so
+     *  that its space is given back when the SpillFile is destroyed, even if
+     *  the process crashes.
+     *
+     *  The spill file is not thread-safe, it has to be used from the thread
+     *  running the aligner.
+     */
+    class SpillFile
+    {
+    protected:
+        /** record header, followed by the payload padded to 8 bytes **/
+        struct Record
+        {
+            int64_t time;
+            uint64_t size;
+        };
+
+        static const size_t ALIGNMENT = sizeof(Record);
+
+        /** size of the file when it is created **/
+        static const size_t INITIAL_SIZE = 1 << 20;
+
+        int fd;
+        char *data;
+
+        /** mapped size, equal to the file size **/
+        size_t capacity;
+        size_t max_size;
+
+        /** offsets of the oldest record, and of the end of the newest one **/
+        size_t read_pos, write_pos;
+
+        size_t records;
+
+        static size_t recordSize(size_t payload_size)
+        {
+            return sizeof(Record) + (payload_size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        }
+
+        static void fail(const std::string &what)
+        {
+            throw std::runtime_error("spill file: " + what + ": " + std::strerror(errno));
+        }
+
+        void map(size_t size)
+        {
+            if (this->data)
+                ::munmap(this->data, this->capacity);
+            this->data = NULL;
+
+            if (::ftruncate(this->fd, size) != 0)
+                fail("cannot resize the file");
+
+            void *data = ::mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+            if (data == MAP_FAILED)
+                fail("cannot map the file");
+
+            this->data = static_cast<char*>(data);
+            this->capacity = size;
+        }
+
+        /** @brief makes room for size bytes at the end of the file
+         *
+         *  @return false if the file would be larger than max_size
+         */
+        bool reserve(size_t size)
+        {
+            if (this->write_pos + size <= this->capacity)
+                return true;
+
+            /** more dead space than live data: compact instead of growing **/
+            size_t used = this->write_pos - this->read_pos;
+            if (this->read_pos >= used && used + size <= this->capacity)
+            {
+                std::memmove(this->data, this->data + this->read_pos, used);
+                this->read_pos = 0;
+                this->write_pos = used;
+                return true;
+            }
+
+            size_t new_capacity = this->capacity;
+            while (new_capacity < this->write_pos + size)
+                new_capacity *= 2;
+            if (new_capacity > this->max_size)
+                new_capacity = this->max_size;
+            if (new_capacity < this->write_pos + size)
+                return false;
+
+            this->map(new_capacity);
+            return true;
+        }
+
+    public:
+        /** @brief Constructor
+         *
+         *  @param directory directory the file is created in, under a
+         *  unique name so that no existing file is touched
+         *  @param max_size maximum size of the file in bytes
+         *  @throw std::runtime_error if the file cannot be created or mapped
+         */
+        SpillFile(const std::string &directory, size_t max_size)
+            : fd(-1), data(NULL), capacity(0), max_size(max_size),
+              read_pos(0), write_pos(0), records(0)
+        {
+            long page_size = ::sysconf(_SC_PAGESIZE);
+            this->max_size = (max_size + page_size - 1) / page_size * page_size;
+            if (this->max_size == 0)
+                throw std::runtime_error("spill file: the maximum size must not be zero");
+
+            std::string pattern = directory + "/stream_aligner_spill.XXXXXX";
+            std::vector<char> path(pattern.begin(), pattern.end());
+            path.push_back('\0');
+            this->fd = ::mkstemp(path.data());
+            if (this->fd < 0)
+                fail("cannot create a file in " + directory);
+            ::unlink(path.data());
+
+            try
+            {
+                this->map(INITIAL_SIZE < this->max_size ? INITIAL_SIZE : this->max_size);
+            }
+            catch (...)
+            {
+                ::close(this->fd);
+                throw;
+            }
+        }
+
+        SpillFile(const SpillFile &other) = delete;
+        SpillFile& operator=(const SpillFile &other) = delete;
+
+        ~SpillFile()
+        {
+            if (this->data)
+                ::munmap(this->data, this->capacity);
+            ::close(this->fd);
+        }
+
+        /** @brief appends a sample at the end of the file
+         *
+         *  @return false if the file reached its maximum size. Nothing is
+         *  written in that case.
+         */
+        template <class T>
+        bool push_back(const base::Time &ts, const T &value)
+        {
+            size_t payload_size = SampleSerializer<T>::size(value);
+            size_t size = recordSize(payload_size);
+            if (!this->reserve(size))
+                return false;
+
+            Record *record = reinterpret_cast<Record*>(this->data + this->write_pos);
+            record->time = ts.toMicroseconds();
+            record->size = payload_size;
+            SampleSerializer<T>::write(value, reinterpret_cast<char*>(record + 1));
+
+            this->write_pos += size;
+            this->records++;
+            return true;
+        }
+
+        /** @brief reads the oldest sample. The file must not be empty
+         */
+        template <class T>
+        void front(base::Time &ts, T &value) const
+        {
+            const Record *record = reinterpret_cast<const Record*>(this->data + this->read_pos);
+            ts = base::Time::fromMicroseconds(record->time);
+            SampleSerializer<T>::read(reinterpret_cast<const char*>(record + 1), record->size, value);
+        }
+
+        /** @brief removes the oldest sample. The file must not be empty
+         */
+        void pop_front()
+        {
+            const Record *record = reinterpret_cast<const Record*>(this->data + this->read_pos);
+            this->read_pos += recordSize(record->size);
+            if (--this->records == 0)
+                this->read_pos = this->write_pos = 0;
+        }
+
+        /** @brief removes all the samples
+         */
+        void clear()
+        {
+            this->read_pos = this->write_pos = 0;
+            this->records = 0;
+        }
+
+        /** @brief copies the samples of another spill file
+         *
+         *  @throw std::runtime_error if they do not fit in this file
+         */
+        void assign(const SpillFile &other)
+        {
+            if (this == &other)
+                return;
+
+            this->clear();
+            size_t used = other.write_pos - other.read_pos;
+            if (!this->reserve(used))
+                throw std::runtime_error("spill file: maximum size reached while copying");
+
+            std::memcpy(this->data, other.data + other.read_pos, used);
+            this->write_pos = used;
+            this->records = other.records;
+        }
+
+        bool empty() const { return this->records == 0; }
+
+        /** @return the number of samples in the file **/
+        size_t size() const { return this->records; }
+
+        /** @return the number of bytes used by the samples **/
+        size_t bytes() const { return this->write_pos - this->read_pos; }
+
+        /** @return the size of the file **/
+        size_t fileSize() const { return this->capacity; }
+
+        size_t maxSize() const { return this->max_size; }
+    };
+}
+#endif
@@ -0,0 +1,499 @@
+#ifndef STREAM_ALIGNER_STATIC_STREAM_ALIGNER_HPP
+#define STREAM_ALIGNER_STATIC_STREAM_ALIGNER_HPP
+
+#include <stream_aligner/StreamAligner.hpp>
+#include <stream_aligner/IndexSequence.hpp>
+#include <stream_aligner/StreamSelector.hpp>
+
+#include <base/Time.hpp>
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace stream_aligner
+{
+    /**
+     * StreamSpec
+     *
+     * @brief Type of the samples and buffer size of a stream of a
+     * StaticStreamAligner
+     *
+     * */
+    template <class T, size_t BUFFER_SIZE>
+    struct StreamSpec
+    {
+        typedef T value_type;
+        typedef Stream<T, BUFFER_SIZE> stream_type;
+        static const size_t buffer_size = BUFFER_SIZE;
+    };
+
+    /**
+     * SizedStreamSpec
+     *
+     * @brief StreamSpec whose buffer size is computed at compile time from
+     * the period of the stream and the timeout of the aligner
+     *
+     * The buffer holds SAFETY_PERCENT percent of the samples the stream
+     * receives during the timeout, see bufferSize(). The durations are in
+     * microseconds. It can describe a stream of a StreamAligner as well:
+     *
+     *   typedef SizedStreamSpec<ImuSample, 10000, 200000> Imu;
+     *   aligner.registerStream<Imu::value_type, Imu::buffer_size>(callback, Imu::period());
+     *
+     * */
+    template <class T, int64_t PERIOD_US, int64_t TIMEOUT_US, unsigned SAFETY_PERCENT = 200>
+    struct SizedStreamSpec : public StreamSpec<T, bufferSize(PERIOD_US, TIMEOUT_US, SAFETY_PERCENT)>
+    {
+        static_assert(PERIOD_US != 0, "an aperiodic stream cannot be sized from its period");
+        static_assert(SAFETY_PERCENT >= 100, "the buffer must hold at least the samples received during the timeout");
+
+        static base::Time period() { return base::Time::fromMicroseconds(PERIOD_US); }
+        static base::Time timeout() { return base::Time::fromMicroseconds(TIMEOUT_US); }
+    };
+
+    /**
+     * StaticStreamAligner
+     *
+     * @brief StreamAligner whose streams are known at compile time
+     *
+     * Each stream is described by a StreamSpec, and its index is its
+     * position in Specs:
+     *
+     *   StaticStreamAligner< StreamSpec<ImuSample, 64>, StreamSpec<Image, 4> > aligner;
+     *   aligner.registerStream<0>(imu_callback, imu_period);
+     *   aligner.push<0>(ts, imu_sample);
+     *
+     * The streams are held by value in a std::tuple and the stream index is
+     * a template parameter, so that pushing and releasing a sample involve
+     * no virtual call nor cast and can be inlined, and registering a stream
+     * allocates nothing, except for a name longer than what std::string
+     * stores in place. The next sample is selected by a StreamSelector.
+     *
+     * The release order is the one of StreamAligner for the same input.
+     * The per-stream settings (reorder window, decimation, overflow policy)
+     * are set on the stream returned by getStream(). Concurrent streams,
+     * buffer growth, spilling, synchronizers and recording are only
+     * provided by StreamAligner.
+     *
+     * */
+    template <class... Specs>
+    class StaticStreamAligner
+    {
+    public:
+        static const size_t NUMBER_STREAMS = sizeof...(Specs);
+        static_assert(NUMBER_STREAMS > 0, "a StaticStreamAligner needs at least one stream");
+
+        template <size_t I> using spec_type = typename std::tuple_element<I, std::tuple<Specs...> >::type;
+        template <size_t I> using stream_type = typename spec_type<I>::stream_type;
+        template <size_t I> using value_type = typename spec_type<I>::value_type;
+
+    protected:
+        typedef typename MakeIndexSequence<NUMBER_STREAMS>::type indices_t;
+
+        std::tuple<typename Specs::stream_type...> streams;
+
+        std::array<bool, NUMBER_STREAMS> registered;
+
+        /** next timestamps of the streams **/
+        StreamSelector<NUMBER_STREAMS> selector;
+
+        /** The timeout **/
+        ticks_t timeout;
+
+        /** time of the last sample that came in */
+        ticks_t latest_ts;
+
+        /** time of the last sample that went out */
+        ticks_t current_ts;
+
+        size_t samples_dropped_late_arriving;
+
+    protected:
+        /** Calls to the streams are qualified with their type, which
+         * bypasses the virtual functions of StreamBase */
+        template <size_t I> void updateStreamOrder()
+        {
+            typedef stream_type<I> S;
+            const S &stream(std::get<I>(streams));
+
+            if(stream.S::hasData())
+                selector.setData(I, stream.S::latestTimeStamp(), stream.S::getPriority());
+            else if(registered[I] && stream.isActive())
+                selector.setWaiting(I, stream.S::latestTimeStamp(), stream.S::getPriority());
+            else
+                selector.remove(I);
+        }
+
+        template <size_t... I> void updateStreamOrder(IndexSequence<I...>)
+        {
+            int expand[] = { 0, (updateStreamOrder<I>(), 0)... };
+            (void)expand;
+        }
+
+        /** Extends the window with the data of stream I, see
+         * StreamAligner::timeoutWindow */
+        template <size_t I> void extendDataWindow(ticks_t &firstDataTime, ticks_t &latestDataTime) const
+        {
+            typedef stream_type<I> S;
+            const S &stream(std::get<I>(streams));
+            if(!stream.S::hasData())
+                return;
+
+            if(latestDataTime < stream.S::latestDataTime())
+                latestDataTime = stream.S::latestDataTime();
+
+            if(firstDataTime == 0 || firstDataTime > stream.S::earliestDataTime())
+                firstDataTime = stream.S::earliestDataTime();
+        }
+
+        template <size_t... I> void extendDataWindow(ticks_t &firstDataTime, ticks_t &latestDataTime, IndexSequence<I...>) const
+        {
+            int expand[] = { 0, (extendDataWindow<I>(firstDataTime, latestDataTime), 0)... };
+            (void)expand;
+        }
+
+        void timeoutWindow(ticks_t &firstDataTime, ticks_t &latestDataTime) const
+        {
+            if(current_ts == 0)
+            {
+                extendDataWindow(firstDataTime, latestDataTime, indices_t());
+                if(latestDataTime < latest_ts)
+                    latestDataTime = latest_ts;
+            }
+            else
+            {
+                latestDataTime = latest_ts;
+                firstDataTime = current_ts;
+            }
+        }
+
+        bool timedOut() const
+        {
+            ticks_t latestDataTime = 0;
+            ticks_t firstDataTime = 0;
+            timeoutWindow(firstDataTime, latestDataTime);
+
+            return !(latestDataTime - firstDataTime < timeout);
+        }
+
+        /** @see StreamAligner::nextReleasable */
+        int nextReleasable() const
+        {
+            int next = selector.nextData();
+            if(next == -1)
+                return -1;
+
+            if(selector.nextWaitingTime() < selector.dataTime(next) && !timedOut())
+                return -1;
+            return next;
+        }
+
+        /** Gives the oldest sample of the stream with the given index to its
+         * callback. The index is matched against the streams in turn, so
+         * that each pop is a direct call */
+        template <size_t I> void release(size_t idx, std::integral_constant<size_t, I>)
+        {
+            if(idx != I)
+            {
+                release(idx, std::integral_constant<size_t, I + 1>());
+                return;
+            }
+
+            typedef stream_type<I> S;
+            current_ts = std::get<I>(streams).S::pop();
+            updateStreamOrder<I>();
+        }
+
+        void release(size_t, std::integral_constant<size_t, NUMBER_STREAMS>)
+        {
+        }
+
+        void release(size_t idx)
+        {
+            release(idx, std::integral_constant<size_t, 0>());
+        }
+
+        /** @see StreamAligner::acceptSample */
+        bool acceptSample(StreamBase &stream, ticks_t ts)
+        {
+            stream.status.samples_received++;
+            stream.status.latest_sample_time = fromTicks(ts);
+            stream.setActive( true );
+
+            if(ts < current_ts)
+            {
+                samples_dropped_late_arriving++;
+                stream.status.samples_dropped_late_arriving++;
+                return false;
+            }
+
+            if( ts > latest_ts )
+                latest_ts = ts;
+
+            if( stream.decimate(ts) )
+            {
+                stream.status.samples_dropped_decimation++;
+                return false;
+            }
+
+            return true;
+        }
+
+        template <size_t I> stream_type<I> &registeredStream()
+        {
+            if(!registered[I])
+                throw std::runtime_error("invalid stream index.");
+            return std::get<I>(streams);
+        }
+
+        template <size_t I> void clearStream()
+        {
+            typedef stream_type<I> S;
+            std::get<I>(streams).S::clear();
+        }
+
+        template <size_t I> void updateRequiredBufferSize()
+        {
+            stream_type<I> &stream(std::get<I>(streams));
+            stream.status.buffer_size_required = samplesInTimeout(stream.getPeriod().toMicroseconds(), timeout);
+        }
+
+        template <size_t... I> void updateRequiredBufferSize(IndexSequence<I...>)
+        {
+            int expand[] = { 0, (updateRequiredBufferSize<I>(), 0)... };
+            (void)expand;
+        }
+
+        /** @throw std::runtime_error if the buffer of stream I is too small
+         * for the timeout */
+        template <size_t I> void checkBufferSize() const
+        {
+            typedef stream_type<I> S;
+            const S &stream(std::get<I>(streams));
+            if(!registered[I] || !stream.S::isBounded())
+                return;
+
+            const StreamStatus &status(stream.status);
+            if(spec_type<I>::buffer_size < status.buffer_size_required)
+            {
+                std::ostringstream message;
+                message << "the buffer of stream " << I << " (" << status.name << ") holds "
+                    << spec_type<I>::buffer_size << " samples, its period and the timeout require "
+                    << status.buffer_size_required;
+                throw std::runtime_error(message.str());
+            }
+        }
+
+        template <size_t... I> void checkBufferSizes(IndexSequence<I...>) const
+        {
+            int expand[] = { 0, (checkBufferSize<I>(), 0)... };
+            (void)expand;
+        }
+
+        template <size_t... I> void clearStreams(IndexSequence<I...>)
+        {
+            int expand[] = { 0, (clearStream<I>(), 0)... };
+            (void)expand;
+        }
+
+    public:
+        explicit StaticStreamAligner(base::Time timeout = base::Time::fromSeconds(1))
+            : timeout(toTicks(timeout)), latest_ts(0), current_ts(0), samples_dropped_late_arriving(0)
+        {
+            registered.fill(false);
+            updateStreamOrder(indices_t());
+        }
+
+        StaticStreamAligner(const StaticStreamAligner &other) = delete;
+        StaticStreamAligner& operator=(const StaticStreamAligner &other) = delete;
+
+        /** Registers the stream of index I
+         *
+         * @see StreamAligner::registerStream for the parameters. The name
+         * is copied in the status, which allocates if it does not fit in
+         * the small string storage of std::string
+         * @throw std::runtime_error if the stream is registered already
+         */
+        template <size_t I> void registerStream( typename stream_type<I>::callback_t callback, base::Time period, int priority = -1, const std::string &name = std::string())
+        {
+            if(registered[I])
+                throw std::runtime_error("stream already registered.");
+
+            stream_type<I> &stream(std::get<I>(streams));
+            stream.setCallback(callback);
+            stream.setPeriod(period);
+            stream.setPriority(priority);
+            stream.status.name = name;
+            stream.setActive(true);
+            registered[I] = true;
+            updateRequiredBufferSize<I>();
+            updateStreamOrder<I>();
+        }
+
+        /** Unregisters the stream of index I, dropping its samples */
+        template <size_t I> void unregisterStream()
+        {
+            stream_type<I> &stream(registeredStream<I>());
+            clearStream<I>();
+            stream.setCallback(typename stream_type<I>::callback_t());
+            registered[I] = false;
+            updateStreamOrder<I>();
+        }
+
+        template <size_t I> bool isRegistered() const { return registered[I]; }
+
+        /** @return the stream of index I, to change its settings */
+        template <size_t I> stream_type<I> &getStream() { return std::get<I>(streams); }
+        template <size_t I> const stream_type<I> &getStream() const { return std::get<I>(streams); }
+
+        /** @brief Push new data into the stream of index I
+         *
+         * @throw std::runtime_error if the stream is not registered
+         * @see StreamAligner::push
+         */
+        template <size_t I> void push( const base::Time &ts, const value_type<I> &data )
+        {
+            stream_type<I> &stream(registeredStream<I>());
+            if( acceptSample(stream, toTicks(ts)) )
+                stream.push(ts, data);
+            updateStreamOrder<I>();
+        }
+
+        /** @overload moves the data into the stream buffer
+         */
+        template <size_t I> void push( const base::Time &ts, value_type<I> &&data )
+        {
+            stream_type<I> &stream(registeredStream<I>());
+            if( acceptSample(stream, toTicks(ts)) )
+                stream.push(ts, std::move(data));
+            updateStreamOrder<I>();
+        }
+
+        /** @brief Construct new data in the stream of index I
+         *
+         * @see StreamAligner::emplace
+         */
+        template <size_t I, class... Args> void emplace( const base::Time &ts, Args&&... args )
+        {
+            stream_type<I> &stream(registeredStream<I>());
+            if( acceptSample(stream, toTicks(ts)) )
+                stream.emplace(ts, std::forward<Args>(args)...);
+            updateStreamOrder<I>();
+        }
+
+        /** @see StreamAligner::step */
+        bool step()
+        {
+            int next = nextReleasable();
+            if(next == -1)
+                return false;
+
+            release(next);
+            return true;
+        }
+
+        /** @see StreamAligner::stepN */
+        size_t stepN(size_t max_samples)
+        {
+            size_t count = 0;
+            int next;
+            while(count < max_samples && (next = nextReleasable()) != -1)
+            {
+                release(next);
+                count++;
+            }
+            return count;
+        }
+
+        /** @see StreamAligner::stepUntil */
+        size_t stepUntil(const base::Time &time)
+        {
+            ticks_t until = toTicks(time);
+            size_t count = 0;
+            int next;
+            while((next = nextReleasable()) != -1 && !(until < selector.dataTime(next)))
+            {
+                release(next);
+                count++;
+            }
+            return count;
+        }
+
+        /** @see StreamAligner::drain */
+        size_t drain()
+        {
+            return stepN(std::numeric_limits<size_t>::max());
+        }
+
+        /** @see StreamAligner::advanceTime */
+        void advanceTime(const base::Time &time)
+        {
+            ticks_t ticks = toTicks(time);
+            if( ticks > latest_ts )
+                latest_ts = ticks;
+        }
+
+        /** @see StreamAligner::disableStream */
+        template <size_t I> void disableStream()
+        {
+            registeredStream<I>().setActive(false);
+            updateStreamOrder<I>();
+        }
+
+        /** @see StreamAligner::enableStream */
+        template <size_t I> void enableStream()
+        {
+            registeredStream<I>().setActive(true);
+            updateStreamOrder<I>();
+        }
+
+        template <size_t I> bool isStreamActive() const
+        {
+            return registered[I] && std::get<I>(streams).isActive();
+        }
+
+        /** @see StreamAligner::clear */
+        void clear()
+        {
+            clearStreams(indices_t());
+            latest_ts = 0;
+            current_ts = 0;
+            samples_dropped_late_arriving = 0;
+            updateStreamOrder(indices_t());
+        }
+
+        void setTimeout(const base::Time &t)
+        {
+            timeout = toTicks(t);
+            updateRequiredBufferSize(indices_t());
+        }
+
+        /** @see StreamAligner::checkBufferSizes */
+        void checkBufferSizes() const
+        {
+            checkBufferSizes(indices_t());
+        }
+
+        base::Time getTimeOut() const { return fromTicks(timeout); }
+        base::Time getLatency() const { return fromTicks(latest_ts - current_ts); }
+        base::Time getCurrentTime() const { return fromTicks(current_ts); }
+        base::Time getLatestTime() const { return fromTicks(latest_ts); }
+
+        size_t getSamplesDroppedLateArriving() const { return samples_dropped_late_arriving; }
+
+        /** @return the status of the stream of index I */
+        template <size_t I> const StreamStatus &getBufferStatus() const
+        {
+            typedef stream_type<I> S;
+            return std::get<I>(streams).S::getBufferStatus();
+        }
+    };
+}
+#endif
@@ -0,0 +1,301 @@
+#ifndef STREAM_ALIGNER_STATUS_PUBLISHER_HPP
+#define STREAM_ALIGNER_STATUS_PUBLISHER_HPP
+
+#include <stream_aligner/StreamAlignerStatus.hpp>
+#include <stream_aligner/StreamStorage.hpp>
+
+#include <base/Time.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace stream_aligner
+{
+    /** @brief Status of a single stream, as published by a StatusPublisher
+     *
+     *  Same content as StreamStatus, without the std::string: the name
+     *  points to a copy interned by the publisher when the stream got
+     *  registered, which stays valid as long as the publisher.
+     */
+    struct StreamSnapshot
+    {
+        uint64_t buffer_size;
+        uint64_t buffer_size_required;
+        uint64_t buffer_fill;
+        uint64_t samples_received;
+        uint64_t samples_processed;
+        uint64_t samples_dropped_buffer_full;
+        uint64_t samples_dropped_late_arriving;
+        uint64_t samples_dropped_queue_full;
+        uint64_t samples_dropped_decimation;
+        uint64_t samples_blocked;
+        uint64_t samples_reordered;
+        uint64_t samples_backward_in_time;
+        uint64_t buffer_growths;
+        uint64_t buffer_shrinks;
+        uint64_t samples_spilled;
+        uint64_t spill_fill;
+        base::Time time_in_buffer_p50;
+        base::Time time_in_buffer_p99;
+        base::Time time_in_buffer_max;
+        base::Time latest_data_time;
+        base::Time earliest_data_time;
+        base::Time latest_sample_time;
+        int64_t priority;
+        /** interned name of the stream, never NULL **/
+        const char *name;
+        /** false for a stream which is disabled or not registered **/
+        bool active;
+
+        StreamSnapshot() : buffer_size(0), buffer_size_required(0), buffer_fill(0), samples_received(0),
+                samples_processed(0), samples_dropped_buffer_full(0),
+                samples_dropped_late_arriving(0), samples_dropped_queue_full(0),
+                samples_dropped_decimation(0), samples_blocked(0),
+                samples_reordered(0), samples_backward_in_time(0),
+                buffer_growths(0), buffer_shrinks(0), samples_spilled(0),
+                spill_fill(0), priority(0), name(""), active(false)
+        {
+        }
+
+        void assign(const StreamStatus &status, const char *name)
+        {
+            this->buffer_size = status.buffer_size;
+            this->buffer_size_required = status.buffer_size_required;
+            this->buffer_fill = status.buffer_fill;
+            this->samples_received = status.samples_received;
+            this->samples_processed = status.samples_processed;
+            this->samples_dropped_buffer_full = status.samples_dropped_buffer_full;
+            this->samples_dropped_late_arriving = status.samples_dropped_late_arriving;
+            this->samples_dropped_queue_full = status.samples_dropped_queue_full;
+            this->samples_dropped_decimation = status.samples_dropped_decimation;
+            this->samples_blocked = status.samples_blocked;
+            this->samples_reordered = status.samples_reordered;
+            this->samples_backward_in_time = status.samples_backward_in_time;
+            this->buffer_growths = status.buffer_growths;
+            this->buffer_shrinks = status.buffer_shrinks;
+            this->samples_spilled = status.samples_spilled;
+            this->spill_fill = status.spill_fill;
+            this->time_in_buffer_p50 = status.time_in_buffer_p50;
+            this->time_in_buffer_p99 = status.time_in_buffer_p99;
+            this->time_in_buffer_max = status.time_in_buffer_max;
+            this->latest_data_time = status.latest_data_time;
+            this->earliest_data_time = status.earliest_data_time;
+            this->latest_sample_time = status.latest_sample_time;
+            this->priority = status.priority;
+            this->name = name;
+            this->active = status.active;
+        }
+    };
+
+    /** @brief Status of the stream aligner itself, as published by a
+     * StatusPublisher. @see StreamAlignerStatus */
+    struct AlignerSnapshot
+    {
+        /** number of publications so far, 0 if nothing was published **/
+        uint64_t publications;
+        /** time of the publication **/
+        base::Time time;
+        base::Time current_time;
+        base::Time latest_time;
+        uint64_t samples_dropped_late_arriving;
+        /** number of valid elements in StatusSnapshot::streams **/
+        uint64_t stream_count;
+
+        AlignerSnapshot() : publications(0), samples_dropped_late_arriving(0), stream_count(0)
+        {
+        }
+    };
+
+    /** @brief Complete status of a stream aligner, as read from a
+     * StatusPublisher
+     *
+     *  For a DynamicStreamAligner, streams grows to the capacity of the
+     *  publisher on the first read. Reuse the snapshot so that later reads
+     *  do not allocate.
+     */
+    template <size_t NUMBER_STREAMS>
+    struct StatusSnapshot : public AlignerSnapshot
+    {
+        typename StreamStorage<StreamSnapshot, NUMBER_STREAMS>::type streams;
+    };
+
+    /** @brief StatusPublisher
+     *
+     *  Makes the status of a stream aligner available to other threads
+     *  without locking the thread running the aligner. The aligner writes
+     *  its counters in the publisher with StreamAligner::publishStatus(),
+     *  and any number of threads read them with read() at their own pace.
+     *
+     *  The status is protected by a sequence lock: the writer never waits,
+     *  and the readers retry if a publication happened while they were
+     *  copying. Neither side allocates once the publisher is built, and
+     *  the stream names are copied once, when the streams are registered.
+     *
+     *  The status is stored as words accessed atomically, so that a read
+     *  racing with a publication is well-defined, and then thrown away.
+     */
+    template <size_t NUMBER_STREAMS>
+    class StatusPublisher
+    {
+    protected:
+        static const size_t ALIGNER_WORDS = (sizeof(AlignerSnapshot) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+        static const size_t STREAM_WORDS = (sizeof(StreamSnapshot) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+        /** odd while a publication is in progress **/
+        std::atomic<uint64_t> sequence;
+
+        size_t capacity;
+        std::unique_ptr< std::atomic<uint64_t>[] > words;
+
+        /** writer side: the next status to publish **/
+        StatusSnapshot<NUMBER_STREAMS> pending;
+
+        /** writer side: the interned names, indexed by stream **/
+        std::vector<const char*> stream_names;
+
+        /** every name ever given to the publisher. Elements of a deque are
+         * not moved when it grows, so the readers can keep pointers on
+         * them **/
+        std::deque<std::string> names;
+
+        template <class V>
+        void store(size_t offset, const V &value)
+        {
+            uint64_t buffer[(sizeof(V) + sizeof(uint64_t) - 1) / sizeof(uint64_t)] = { 0 };
+            std::memcpy(buffer, &value, sizeof(V));
+            for (size_t i = 0; i < sizeof(buffer) / sizeof(uint64_t); ++i)
+                this->words[offset + i].store(buffer[i], std::memory_order_relaxed);
+        }
+
+        template <class V>
+        void load(size_t offset, V &value) const
+        {
+            uint64_t buffer[(sizeof(V) + sizeof(uint64_t) - 1) / sizeof(uint64_t)];
+            for (size_t i = 0; i < sizeof(buffer) / sizeof(uint64_t); ++i)
+                buffer[i] = this->words[offset + i].load(std::memory_order_relaxed);
+            std::memcpy(&value, buffer, sizeof(V));
+        }
+
+        static size_t defaultCapacity(size_t capacity)
+        {
+            if (NUMBER_STREAMS && capacity > NUMBER_STREAMS)
+                throw std::runtime_error("status publisher: capacity larger than the number of streams");
+            return NUMBER_STREAMS ? NUMBER_STREAMS : capacity;
+        }
+
+    public:
+        static_assert(std::is_trivially_copyable<StreamSnapshot>::value && std::is_trivially_copyable<AlignerSnapshot>::value,
+                "the snapshots are copied word by word");
+
+        /** @brief Constructor
+         *
+         *  @param capacity maximum number of streams published. Unused for
+         *  a StreamAligner of fixed size, which publishes all its streams.
+         *  The streams of a DynamicStreamAligner whose index is past the
+         *  capacity are not published.
+         */
+        explicit StatusPublisher(size_t capacity = NUMBER_STREAMS)
+            : sequence(0), capacity(defaultCapacity(capacity)),
+              words(new std::atomic<uint64_t>[ALIGNER_WORDS + this->capacity * STREAM_WORDS]),
+              stream_names(this->capacity, "")
+        {
+            StreamStorage<StreamSnapshot, NUMBER_STREAMS>::resize(this->pending.streams, this->capacity);
+            for (size_t i = 0; i < ALIGNER_WORDS + this->capacity * STREAM_WORDS; ++i)
+                this->words[i].store(0, std::memory_order_relaxed);
+
+            this->store(0, AlignerSnapshot());
+            for (size_t i = 0; i < this->capacity; ++i)
+                this->store(ALIGNER_WORDS + i * STREAM_WORDS, StreamSnapshot());
+        }
+
+        StatusPublisher(const StatusPublisher &other) = delete;
+        StatusPublisher& operator=(const StatusPublisher &other) = delete;
+
+        size_t getCapacity() const { return this->capacity; }
+
+        /** @return a copy of name which stays valid as long as the
+         * publisher. Equal names share the same copy */
+        const char *intern(const std::string &name)
+        {
+            for (std::deque<std::string>::const_iterator it = this->names.begin(); it != this->names.end(); ++it)
+            {
+                if (*it == name)
+                    return it->c_str();
+            }
+            this->names.push_back(name);
+            return this->names.back().c_str();
+        }
+
+        /** @brief sets the name of the stream with the given index. Called
+         * by the aligner when the stream is registered */
+        void setName(size_t idx, const std::string &name)
+        {
+            if (idx < this->capacity)
+                this->stream_names[idx] = this->intern(name);
+        }
+
+        /** @return the interned name of the stream with the given index **/
+        const char *getName(size_t idx) const
+        {
+            return idx < this->capacity ? this->stream_names[idx] : "";
+        }
+
+        /** @brief writer side: the status filled by the aligner, published
+         * by publish() */
+        StatusSnapshot<NUMBER_STREAMS> &prepare() { return this->pending; }
+
+        /** @brief writer side: makes the prepared status visible to the
+         * readers. Never blocks */
+        void publish()
+        {
+            uint64_t seq = this->sequence.load(std::memory_order_relaxed);
+            this->pending.publications = seq / 2 + 1;
+
+            this->sequence.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            this->store(0, static_cast<const AlignerSnapshot&>(this->pending));
+            for (size_t i = 0; i < this->pending.stream_count; ++i)
+                this->store(ALIGNER_WORDS + i * STREAM_WORDS, this->pending.streams[i]);
+
+            this->sequence.store(seq + 2, std::memory_order_release);
+        }
+
+        /** @brief reader side: copies the last published status
+         *
+         *  Thread-safe, and does not wait for the writer: the copy is
+         *  retried if the writer published in the meantime.
+         */
+        void read(StatusSnapshot<NUMBER_STREAMS> &snapshot) const
+        {
+            StreamStorage<StreamSnapshot, NUMBER_STREAMS>::resize(snapshot.streams, this->capacity);
+            while (true)
+            {
+                uint64_t seq = this->sequence.load(std::memory_order_acquire);
+                if (seq & 1)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                this->load(0, static_cast<AlignerSnapshot&>(snapshot));
+                size_t count = snapshot.stream_count < this->capacity ? snapshot.stream_count : this->capacity;
+                for (size_t i = 0; i < count; ++i)
+                    this->load(ALIGNER_WORDS + i * STREAM_WORDS, snapshot.streams[i]);
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (this->sequence.load(std::memory_order_relaxed) == seq)
+                    return;
+            }
+        }
+    };
+}
+#endif
@@ -2,24 +2,67 @@
 #define STREAM_ALIGNER_STREAM_ALIGNER_HPP
 
 #include <stream_aligner/StreamAlignerStatus.hpp>
+#include <stream_aligner/BufferSize.hpp>
 #include <stream_aligner/CircularArray.hpp>
+#include <stream_aligner/ChunkPool.hpp>
+#include <stream_aligner/InplaceFunction.hpp>
+#include <stream_aligner/IngestQueue.hpp>
+#include <stream_aligner/LatencyHistogram.hpp>
+#include <stream_aligner/SpillFile.hpp>
+#include <stream_aligner/StatusPublisher.hpp>
+#include <stream_aligner/StreamRecorder.hpp>
+#include <stream_aligner/StreamSelector.hpp>
+#include <stream_aligner/StreamStorage.hpp>
+#include <stream_aligner/Synchronizer.hpp>
+#include <stream_aligner/Ticks.hpp>
 
 #include <base/Time.hpp>
 
 #include <boost/function.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <vector>
 #include <stdexcept>
 #include <iostream>
+#include <sstream>
 #include <cmath>
+#include <tuple>
+#include <utility>
+#include <limits>
 
 namespace stream_aligner
 {
+    /** What a stream does with a new sample when its buffer is full, and
+     * cannot grow */
+    enum OverflowPolicy
+    {
+        /** the oldest sample is overwritten (default) */
+        OVERWRITE_OLDEST,
+        /** the new sample is dropped */
+        DROP_NEWEST,
+        /** the buffered samples are dropped, only the new one is kept */
+        KEEP_LATEST,
+        /** the producers of a concurrent stream wait for room, up to a
+         * timeout, before dropping the new sample. Samples pushed by the
+         * thread running the aligner are dropped as with DROP_NEWEST */
+        BLOCK
+    };
+
     /**
      * StreamBase
      *
      * @brief Base class of Stream
      *
+     * The times returned by the virtual functions are in ticks, for the
+     * aligners. @see Ticks.hpp
+     *
      * */
     class StreamBase
 	{
@@ -30,22 +73,88 @@ namespace stream_aligner
         /** marks a stream as active or inactive. All streams are active by default. */
         bool active;
 
+        /** how much older than the newest sample a sample may be, to still
+         * be inserted at its place instead of being dropped */
+        ticks_t reorder_window;
+
+        /** only one sample out of decimation is kept **/
+        size_t decimation;
+        size_t decimation_count;
+
+        /** minimum time between two kept samples **/
+        ticks_t min_interval;
+        ticks_t last_kept_time;
+
+        /** action when the buffer is full **/
+        OverflowPolicy overflow_policy;
+
+        /** how long a producer waits for room with the BLOCK policy **/
+        base::Time block_timeout;
+
 	public:
-        StreamBase() : active( true ) {}
+        StreamBase() : active( true ), reorder_window( 0 ), decimation( 1 ), decimation_count( 0 ),
+            min_interval( 0 ), last_kept_time( 0 ), overflow_policy( OVERWRITE_OLDEST ) {}
         virtual ~StreamBase() {}
-        virtual base::Time pop() = 0;
+        virtual ticks_t pop() = 0;
         virtual bool hasData() const = 0;
         virtual int getPriority() const = 0;
-        virtual base::Time latestTimeStamp() const = 0;
-        virtual base::Time latestDataTime() const = 0;
-        virtual base::Time earliestDataTime() const = 0;
+        virtual ticks_t latestTimeStamp() const = 0;
+        virtual ticks_t latestDataTime() const = 0;
+        virtual ticks_t earliestDataTime() const = 0;
         virtual const StreamStatus &getBufferStatus() const = 0;
         virtual void copyState( const StreamBase& other ) = 0;
         virtual void clear() = 0;
+        virtual void setBufferPool( ChunkPool *pool ) = 0;
+        virtual void setSpillFile( SpillFile *file ) = 0;
+        virtual bool canSerialize() const = 0;
+        virtual void pushSerialized( const base::Time &ts, const char *data, size_t size ) = 0;
+        virtual void setLatencyTracking( bool enable ) = 0;
+        virtual const LatencyHistogram *getLatencyHistogram() const = 0;
+        virtual base::Time getPeriod() const = 0;
+        /** @return true if the buffer can neither grow nor spill */
+        virtual bool isBounded() const = 0;
 
         bool isActive() const { return active; }
         void setActive( bool active ) { this->active = active; }
 
+        base::Time getReorderWindow() const { return fromTicks(reorder_window); }
+        void setReorderWindow( const base::Time &window ) { this->reorder_window = toTicks(window); }
+
+        size_t getDecimation() const { return decimation; }
+        void setDecimation( size_t decimation ) { this->decimation = decimation ? decimation : 1; this->decimation_count = 0; }
+
+        base::Time getRateLimit() const { return fromTicks(min_interval); }
+        void setRateLimit( const base::Time &min_interval ) { this->min_interval = toTicks(min_interval); }
+
+        /** @return true if the sample with the given time has to be dropped
+         * by the decimation or the rate limit */
+        bool decimate( ticks_t ts )
+        {
+            if( decimation_count++ % decimation != 0 )
+                return true;
+
+            if( min_interval && last_kept_time && ts - last_kept_time < min_interval )
+                return true;
+
+            last_kept_time = ts;
+            return false;
+        }
+
+        OverflowPolicy getOverflowPolicy() const { return overflow_policy; }
+        const base::Time &getBlockTimeout() const { return block_timeout; }
+        void setOverflowPolicy( OverflowPolicy policy, const base::Time &block_timeout = base::Time() )
+        {
+            this->overflow_policy = policy;
+            this->block_timeout = block_timeout;
+        }
+
+        /** restarts the decimation and the rate limit */
+        void resetDecimation()
+        {
+            decimation_count = 0;
+            last_kept_time = 0;
+        }
+
         friend std::ostream &operator<<(std::ostream &stream, const stream_aligner::StreamBase &base);
 	};
 
@@ -57,6 +166,10 @@ namespace stream_aligner
      * T is the template class of the streams.
      * BUFFER_SIZE This should be at least the amount of samples that can occur in a timeout period.
      *
+     * The timestamps and the samples are stored in two rings kept in step,
+     * so that the operations on the timestamps only (ordering, reordering,
+     * status) read 8 bytes per sample whatever the size of T.
+     *
      * */
 
     template <class T, size_t BUFFER_SIZE>
@@ -64,51 +177,143 @@ namespace stream_aligner
 	{
 	public:
 
-	    typedef boost::function<void (const base::Time &ts, const T &value)> callback_t;
+	    /** Callback type. Any callable fitting in its fixed storage is
+	     * accepted, and no memory gets allocated to store it */
+	    typedef InplaceFunction<void (const base::Time &ts, const T &value)> callback_t;
+
+	    /** Callback taking the samples over: it may move them out, their
+	     * slot is released right after it returns */
+	    typedef InplaceFunction<void (const base::Time &ts, T &value)> sink_t;
 
 	protected:
 
-        /** Define type of the elements in the buffer **/
+        /** Define type of the samples given by getNextSample() **/
 	    typedef std::pair<base::Time,T> item;
 
+        /** Define type of the elements in the overflow **/
+	    typedef std::pair<ticks_t,T> overflow_item;
+
 	protected:
-        stream_aligner::CircularArray<item, BUFFER_SIZE> buffer;
+        /** timestamps of the samples in buffer, at the same positions **/
+        stream_aligner::CircularArray<ticks_t, BUFFER_SIZE> times;
+        stream_aligner::CircularArray<T, BUFFER_SIZE> buffer;
+
+        /** samples newer than the ones in buffer, stored when the buffer is
+         * full and growing is enabled. Refills buffer as it drains */
+        ChunkQueue<overflow_item> overflow;
+        bool growable;
+
+        /** samples newer than the ones in buffer and overflow, written to
+         * disk when neither can hold them. Refills buffer as it drains */
+        std::unique_ptr<SpillFile> spill;
+
+        /** time the samples spend in the buffer, NULL if not measured **/
+        std::unique_ptr<BufferLatency> latency;
+
 	    callback_t callback;
-	    base::Time period; 
-	    base::Time lastTime;
+	    sink_t sink;
+	    ticks_t period;
+	    ticks_t lastTime;
 	    int priority;
 
 	public:
 
 	    Stream(callback_t callback, base::Time period, int priority, const std::string &name):
-            callback(callback), period(period), lastTime(base::Time::fromSeconds(0)), priority(priority)
+            growable(false), callback(callback), period(toTicks(period)), lastTime(0), priority(priority)
         {
             status.name = name;
             status.priority = priority;
             status.buffer_size = buffer.capacity();
         }
 
+	    /** unconfigured stream, which a StaticStreamAligner holds until it
+	     * is registered */
+	    Stream():
+            growable(false), period(0), lastTime(0), priority(-1)
+        {
+            status.priority = priority;
+            status.buffer_size = buffer.capacity();
+        }
+
 	    virtual ~Stream() {};
 
 	    bool getNextSample(item &sample) const
 	    {
-            if(buffer.empty())
+            if(times.empty())
                 return false;
 
-            sample = buffer.front();
+            sample.first = fromTicks(times.front());
+            sample.second = buffer.front();
             return true;
 	    }
 
+	    /** gives access to the next sample without copying it
+	     *
+	     * @param ts set to the time of the sample
+	     * @return the sample, or NULL if the stream has no data. The pointer
+	     * is valid until the sample is popped from the stream.
+	     */
+	    const T* peekNextSample(base::Time &ts) const
+	    {
+            if(times.empty())
+                return NULL;
+
+            ts = fromTicks(times.front());
+            return &buffer.front();
+	    }
+
 	    virtual int getPriority() const
 	    {
     		return priority;
 	    }
 
+	    void setCallback(callback_t callback)
+	    {
+            this->callback = callback;
+	    }
+
+	    /** gives the samples to the sink instead of the callback, which is
+	     * not called anymore as long as a sink is set */
+	    void setSink(sink_t sink)
+	    {
+            this->sink = sink;
+	    }
+
+	    virtual base::Time getPeriod() const
+	    {
+            return fromTicks(period);
+	    }
+
+	    virtual bool isBounded() const
+	    {
+            return !growable && !spill;
+	    }
+
+	    void setPeriod(const base::Time &period)
+	    {
+            this->period = toTicks(period);
+	    }
+
+	    void setPriority(int priority)
+	    {
+            this->priority = priority;
+            status.priority = priority;
+	    }
+
 	    virtual const StreamStatus &getBufferStatus() const
 	    {
-            this->status.buffer_fill = buffer.size();
-            this->status.latest_data_time = latestDataTime();
-            this->status.earliest_data_time = earliestDataTime();
+            this->status.buffer_size = buffer.capacity() + overflow.capacity();
+            this->status.spill_fill = spillSize();
+            this->status.buffer_fill = buffer.size() + overflow.size() + this->status.spill_fill;
+            if(latency)
+            {
+                const LatencyHistogram &histogram(latency->getHistogram());
+                this->status.time_in_buffer_p50 = histogram.percentile(0.5);
+                this->status.time_in_buffer_p99 = histogram.percentile(0.99);
+                this->status.time_in_buffer_max = histogram.max();
+            }
+            this->status.latest_data_time = fromTicks(Stream::latestDataTime());
+            this->status.earliest_data_time = fromTicks(Stream::earliestDataTime());
             this->status.active = isActive();
             return status;
 	    }
@@ -118,42 +323,181 @@ namespace stream_aligner
             const Stream<T, BUFFER_SIZE> &stream(dynamic_cast<const Stream<T, BUFFER_SIZE>& >(other));
 
             lastTime = stream.lastTime;
+            times = stream.times;
             buffer = stream.buffer;
+            overflow = stream.overflow;
+            if(spill)
+                spill->clear();
+            if(stream.spillSize())
+            {
+                if(!spill)
+                    throw std::runtime_error("cannot copy spilled samples to a stream without spill file");
+                spill->assign(*stream.spill);
+            }
             status = stream.status;
+            if(latency)
+                latency->reset(base::Time::now(), size());
 	    }
 
-	    void push(const base::Time &ts, const T &data ) 
+	    /** lets the buffer grow with chunks from the given pool when it is
+	     * full, instead of dropping the oldest samples. NULL disables
+	     * growing, the samples already stored in chunks are kept */
+	    virtual void setBufferPool( ChunkPool *pool )
 	    {
-            if(ts < lastTime)
+            if(pool)
+                overflow.setPool(pool);
+            growable = pool != NULL;
+            if(latency)
+                latency->setMaxTracked(trackedSamples());
+	    }
+
+	    /** writes the samples to the given file, which the stream takes
+	     * ownership of, when they do not fit in the buffer and its overflow
+	     * anymore. NULL disables spilling.
+	     *
+	     * @throw std::runtime_error if the samples cannot be serialized, or
+	     * if samples are in the current spill file
+	     */
+	    virtual void setSpillFile( SpillFile *file )
+	    {
+            std::unique_ptr<SpillFile> new_spill(file);
+            if(file && !canSerialize())
+                throw std::runtime_error("no SampleSerializer for the samples of stream " + status.name);
+            if(spillSize())
+                throw std::runtime_error("cannot change the spill file of stream " + status.name + " while it holds samples");
+            spill = std::move(new_spill);
+	    }
+
+	    virtual bool canSerialize() const
+	    {
+            return SampleSerializer<T>::supported;
+	    }
+
+	    /** @return the number of samples the buffer and its overflow are
+	     * able to hold with the current pool limit. Latency tracking takes
+	     * it when it is enabled and when growing is enabled or disabled */
+	    size_t trackedSamples() const
+	    {
+            size_t samples = buffer.capacity();
+            if(growable && overflow.getPool())
+                samples += overflow.getPool()->maxChunks() * (overflow.getPool()->chunkSize() / sizeof(overflow_item));
+            return samples;
+	    }
+
+	    /** measures the time the samples spend in the buffer, from the
+	     * push to the callback, in a histogram. Only the samples in the
+	     * buffer and its overflow are measured, not the spilled ones */
+	    virtual void setLatencyTracking( bool enable )
+	    {
+            if(!enable)
+                latency.reset();
+            else if(!latency)
             {
-                status.samples_backward_in_time++;
-                return;
+                latency.reset(new BufferLatency(trackedSamples()));
+                latency->reset(base::Time::now(), size());
             }
+	    }
 
-            lastTime = ts;
+	    virtual const LatencyHistogram *getLatencyHistogram() const
+	    {
+            return latency ? &latency->getHistogram() : NULL;
+	    }
 
-            if (buffer.full())
-            {
-                // if the buffer is full, just use the behaviour of the circular
-                // buffer: discard old data.
-                status.samples_dropped_buffer_full++;
-		    }
-            buffer.push_back(std::make_pair(ts, data)); 
+	    /** @return the number of samples stored */
+	    size_t size() const
+	    {
+            return buffer.size() + overflow.size() + spillSize();
+	    }
+
+	    /** @return the number of samples in the spill file */
+	    size_t spillSize() const
+	    {
+            return spill ? spill->size() : 0;
+	    }
+
+	    void push(const base::Time &ts, const T &data ) 
+	    {
+            ticks_t ticks = toTicks(ts);
+            if(!prepareInsert(ticks))
+                return;
+            if(insert(ticks, data))
+                stored(ticks);
+	    }
+
+	    void push(const base::Time &ts, T &&data ) 
+	    {
+            ticks_t ticks = toTicks(ts);
+            if(!prepareInsert(ticks))
+                return;
+            if(insert(ticks, std::move(data)))
+                stored(ticks);
+	    }
+
+	    /** deserializes the sample with SampleSerializer and pushes it */
+	    virtual void pushSerialized(const base::Time &ts, const char *data, size_t size)
+	    {
+            T value;
+            SampleSerializer<T>::read(data, size, value);
+            push(ts, std::move(value));
+	    }
+
+	    /** construct the sample from the given arguments
+	     * and move it into the buffer */
+	    template <class... Args> void emplace(const base::Time &ts, Args&&... args ) 
+	    {
+            ticks_t ticks = toTicks(ts);
+            if(!prepareInsert(ticks))
+                return;
+            if(insert(ticks, std::forward<Args>(args)...))
+                stored(ticks);
 	    }
 
 	    /** take the last item of the stream queue and 
 	     * call the callback 
 	     */
-	    base::Time pop()
+	    ticks_t pop()
 	    {
-            if( hasData() )
+            if( Stream::hasData() )
             {
                 status.samples_processed++;
-                base::Time ts = buffer.front().first;
-                if(callback)
-                    callback(ts, buffer.front().second);
-
-                buffer.pop_front();
+                ticks_t ts = times.front();
+                if(latency)
+                    latency->released(base::Time::now());
+
+                /** give the sample to the callback in place, then release it
+                 * together with its time, so that both rings stay in step
+                 * while the callback runs **/
+                const callback_t &cb(callback);
+                const sink_t &sk(sink);
+                base::Time time(fromTicks(ts));
+                buffer.consume_front([&cb, &sk, &time](T &sample)
+                {
+                    if(sk)
+                        sk(time, sample);
+                    else if(cb)
+                        cb(time, sample);
+                });
+                times.pop_front();
+
+                /** move the oldest sample of the overflow in the buffer **/
+                if(!overflow.empty())
+                {
+                    size_t chunks = overflow.chunks();
+                    times.push_back(overflow.front().first);
+                    buffer.push_back(std::move(overflow.front().second));
+                    overflow.pop_front();
+                    if(overflow.chunks() < chunks)
+                        status.buffer_shrinks++;
+                }
+                /** then read the oldest spilled sample back **/
+                else if(spillSize())
+                {
+                    item sample;
+                    spill->front(sample.first, sample.second);
+                    spill->pop_front();
+                    times.push_back(toTicks(sample.first));
+                    buffer.push_back(std::move(sample.second));
+                }
                 return ts;
             }
     		throw std::runtime_error("pop() called on stream with no data.");
@@ -161,208 +505,1135 @@ namespace stream_aligner
 
 	    bool hasData() const
 	    {
-            return !buffer.empty();
+            return !times.empty();
         }
 
-	    base::Time latestTimeStamp() const
+	    /** @return true if a new sample cannot be stored without dropping
+	     * one */
+	    bool isFull() const
+	    {
+            return buffer.full() && Stream::isBounded();
+	    }
+
+    protected:
+	    /** checks the time of a new sample and updates the statistics
+	     * @return false if the sample has to be dropped */
+	    bool prepareInsert(ticks_t ts)
+	    {
+            if(ts < lastTime)
+            {
+                if(lastTime - ts > reorder_window)
+                {
+                    status.samples_backward_in_time++;
+                    return false;
+                }
+
+                /** inserted at its place by reorder(), and counted there
+                 * once it got stored **/
+                return true;
+            }
+
+            lastTime = ts;
+            return true;
+	    }
+
+	    /** @return the timestamp of the sample at the given position, the
+	     * oldest one being 0 */
+	    ticks_t &timeAt(size_t i)
+	    {
+            if(i < times.size())
+                return times.at(i);
+            return overflow.at(i - times.size()).first;
+	    }
+
+	    /** @return the sample at the given position, the oldest one being 0 */
+	    T &sampleAt(size_t i)
+	    {
+            if(i < buffer.size())
+                return buffer.at(i);
+            return overflow.at(i - buffer.size()).second;
+	    }
+
+	    /** moves the newest sample, with time ts, to its place if it is
+	     * older than the previous samples
+	     * @return the position of the sample */
+	    size_t reorder(ticks_t ts)
+	    {
+            size_t last = times.size() + overflow.size() - 1;
+            if(!(ts < lastTime))
+                return last;
+
+            /** binary search of the first sample newer than ts, on the
+             * timestamps only **/
+            size_t first = 0, end = last;
+            while(first < end)
+            {
+                size_t middle = first + (end - first) / 2;
+                if(ts < timeAt(middle))
+                    end = middle;
+                else
+                    first = middle + 1;
+            }
+
+            /** shift the newer samples **/
+            for(size_t i = last; i > first; --i)
+            {
+                std::swap(timeAt(i), timeAt(i - 1));
+                std::swap(sampleAt(i), sampleAt(i - 1));
+            }
+            return first;
+	    }
+
+	    /** puts the sample just stored, with time ts, at its place */
+	    void stored(ticks_t ts)
+	    {
+            if(ts < lastTime)
+                status.samples_reordered++;
+            size_t position = reorder(ts);
+            if(latency)
+            {
+                latency->pushed(base::Time::now(), size());
+                latency->moved(position);
+            }
+	    }
+
+	    /** drops all the stored samples, for the KEEP_LATEST policy */
+	    void dropAll()
+	    {
+            status.samples_dropped_buffer_full += times.size() + overflow.size() + spillSize();
+            status.buffer_shrinks += overflow.chunks();
+            times.clear();
+            buffer.clear();
+            overflow.clear();
+            if(spill)
+                spill->clear();
+	    }
+
+	    /** stores a new sample with time ts, constructed from the given
+	     * arguments, as the newest one
+	     * @return false if the sample got dropped */
+	    template <class... Args> bool insert(ticks_t ts, Args&&... args)
+	    {
+            if (buffer.full())
+            {
+                /** samples are spilled in order, once a sample got spilled
+                 * the next ones follow it **/
+                if (growable && !spillSize())
+                {
+                    size_t chunks = overflow.chunks();
+                    if (overflow.emplace_back(std::piecewise_construct,
+                            std::forward_as_tuple(ts),
+                            std::forward_as_tuple(std::forward<Args>(args)...)))
+                    {
+                        if(overflow.chunks() > chunks)
+                            status.buffer_growths++;
+                        return true;
+                    }
+                }
+
+                if (spill)
+                {
+                    T sample(std::forward<Args>(args)...);
+                    // a sample older than the previous ones cannot be put
+                    // back at its place once it is on disk
+                    if (!(ts < lastTime))
+                    {
+                        if (spill->push_back(fromTicks(ts), sample))
+                        {
+                            status.samples_spilled++;
+                            return true;
+                        }
+
+                        // the spill file is full
+                        if (this->overflow_policy == KEEP_LATEST)
+                        {
+                            dropAll();
+                            times.push_back(ts);
+                            buffer.push_back(std::move(sample));
+                            return true;
+                        }
+                    }
+                    status.samples_dropped_buffer_full++;
+                    return false;
+                }
+
+                if (this->overflow_policy == KEEP_LATEST)
+                {
+                    dropAll();
+                }
+                else if (this->overflow_policy != OVERWRITE_OLDEST || !overflow.empty())
+                {
+                    // the new sample is discarded. This is also the case when
+                    // the pool is exhausted, since the overflow holds samples
+                    // newer than the buffer
+                    status.samples_dropped_buffer_full++;
+                    return false;
+                }
+                else
+                {
+                    // if the buffer is full, just use the behaviour of the circular
+                    // buffer: discard old data.
+                    status.samples_dropped_buffer_full++;
+                }
+		    }
+            times.push_back(ts);
+            buffer.emplace_back(std::forward<Args>(args)...);
+            return true;
+	    }
+
+    public:
+
+	    ticks_t latestTimeStamp() const
 	    {
-            if( hasData() )
-		        return buffer.front().first;
+            if( Stream::hasData() )
+		        return times.front();
     		else 
     		    return lastTime + period;
 	    }
 
-	    virtual base::Time latestDataTime() const
+	    virtual ticks_t latestDataTime() const
 	    {
 	    	return lastTime;
 	    }
 
-	    virtual base::Time earliestDataTime() const
+	    virtual ticks_t earliestDataTime() const
 	    {
-            if( hasData() )
-                return buffer.front().first;
-            return base::Time();
+            if( Stream::hasData() )
+                return times.front();
+            return 0;
 	    }
 
 	    virtual void clear()
 	    {	
-            lastTime = base::Time();
+            lastTime = 0;
+            times.clear();
             buffer.clear();
+            overflow.clear();
+            if(spill)
+                spill->clear();
+            if(latency)
+                latency->clear();
+            this->resetDecimation();
 
             status.latest_sample_time = base::Time();
             status.latest_data_time = base::Time();
             status.samples_dropped_buffer_full = 0;
             status.samples_dropped_late_arriving = 0;
+            status.samples_dropped_queue_full = 0;
+            status.samples_dropped_decimation = 0;
+            status.samples_spilled = 0;
+            status.samples_reordered = 0;
+            status.samples_backward_in_time = 0;
+            status.buffer_growths = 0;
+            status.buffer_shrinks = 0;
             status.buffer_fill = 0;
             status.active = true;
 	    };
 
         void print()
         {
-            for (stream_aligner::cyclic_iterator<item, BUFFER_SIZE> it(buffer); it.itx() != it.end(); ++it)
+            for (size_t i = 0; i < times.size(); ++i)
             {
-                item element = *it;
-                std::cout<<"time["<<element.first.toString()<<"]: "<<element.second<<"\n";
+                std::cout<<"time["<<fromTicks(times.at(i)).toString()<<"]: "<<buffer.at(i)<<"\n";
             }
         }
 	};
 
     /**
-     * Stream Aligner
+     * StreamHandle
      *
-     * @brief Alignment of streams
+     * @brief Typed reference to a stream registered in a StreamAligner
      *
-     */
-    template<size_t NUMBER_STREAMS>
-    class StreamAligner
+     * It holds both the stream index and the concrete stream, so that data
+     * can be pushed without looking the stream up and casting it. A handle
+     * is invalidated when its stream gets unregistered.
+     *
+     * */
+    template <class T, size_t BUFFER_SIZE>
+    class StreamHandle
     {
+    public:
+        typedef T value_type;
+        typedef Stream<T, BUFFER_SIZE> stream_type;
 
-    protected:
-	    typedef std::array<StreamBase*, NUMBER_STREAMS> StreamArray;
-        template <size_t N> using StreamStatusArray = StreamAlignerStatus<N>; //alias template
-
-    protected:
-
-        /** The streams **/
-        StreamArray streams;
+        /** index of the stream in the aligner **/
+        int index;
 
-        /** The timeout **/
-        base::Time timeout;
+        /** the stream itself, owned by the aligner **/
+        stream_type *stream;
 
-        /** time of the last sample that came in */
-        base::Time latest_ts;
+    public:
+        StreamHandle() : index(-1), stream(NULL) {}
 
-        /** time of the last sample that went out */
-        base::Time current_ts;
+        StreamHandle(int index, stream_type *stream) : index(index), stream(stream) {}
 
-        /** temporary object that gets returned by getStatus, 
-         * in order to avoid dynamic allocation on each call */
-	    mutable StreamStatusArray<NUMBER_STREAMS> status;
+        bool valid() const { return stream != NULL; }
 
-    protected:
-        static bool compareStreams( const StreamBase* b1, const StreamBase* b2 )
-        {
-            if(!b1)
-                return false;
+        /** the handle can be used wherever a stream index is expected **/
+        operator int() const { return index; }
+    };
 
-            if(!b2)
-                return true;
+    /**
+     * ConcurrentStream
+     *
+     * @brief Stream which can be fed from other threads
+     *
+     * Samples are first pushed in a lock-free queue by any number of
+     * producer threads. The thread running the StreamAligner moves them from
+     * the queue to the stream buffer before taking its ordering decisions.
+     *
+     * QUEUE_SIZE must be a power of two. It bounds the number of samples
+     * which can be pending between two calls to the aligner.
+     *
+     * */
+    template <class T, size_t BUFFER_SIZE, size_t QUEUE_SIZE>
+    class ConcurrentStream : public Stream<T, BUFFER_SIZE>
+    {
+    public:
+        typedef std::pair<base::Time,T> item;
 
-            const base::Time &ts1( b1->latestTimeStamp() );
-            const base::Time &ts2( b2->latestTimeStamp() );
+        /** samples pushed by the producers, not yet seen by the aligner **/
+        IngestQueue<item, QUEUE_SIZE> queue;
 
-            if(ts1 == ts2)
-            {
-                if(b1->hasData() && !b2->hasData())
-                    return true;
+        /** samples which did not fit in the queue, not yet accounted for in
+         * the stream status **/
+        std::atomic<size_t> queue_dropped;
 
-                if(!b1->hasData() && b2->hasData())
-                    return false;
+        /** samples whose producer waited for room, not yet accounted for
+         * in the stream status **/
+        std::atomic<size_t> queue_waits;
 
-                return b1->getPriority() < b2->getPriority();
-            }
+        /** producers sleeping until the aligner makes room in the queue **/
+        std::atomic<size_t> blocked_producers;
+        std::mutex room_mutex;
+        std::condition_variable room;
 
-            return ts1 < ts2;
+    public:
+        ConcurrentStream(typename Stream<T, BUFFER_SIZE>::callback_t callback, base::Time period, int priority, const std::string &name):
+            Stream<T, BUFFER_SIZE>(callback, period, priority, name), queue_dropped(0), queue_waits(0), blocked_producers(0)
+        {
         }
 
-
-    public:
-    	explicit StreamAligner(base::Time timeout = base::Time::fromSeconds(1)): timeout(timeout)
+        /** wakes up the producers blocked on a full queue. Called by the
+         * aligner after taking samples out of the queue, it does not
+         * lock when no producer is blocked
+         */
+        void notifyRoom()
         {
-            for(size_t i = 0; i < this->streams.size(); i++)
-            {
-                this->streams[i] = NULL;
-            }
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(!blocked_producers.load(std::memory_order_relaxed))
+                return;
+
+            /** taking the lock makes sure a producer which saw the queue
+             * full is waiting before it is notified **/
+            { std::lock_guard<std::mutex> lock(room_mutex); }
+            room.notify_all();
         }
 
-        virtual ~StreamAligner()
+        /** queues a sample. Thread-safe, and lock-free unless the overflow
+         * policy is BLOCK, in which case the producer waits for room up to
+         * the block timeout
+         *
+         * @return false if the queue was full and the sample got dropped
+         */
+        template <class... Args> bool ingest(const base::Time &ts, Args&&... args)
         {
-    	    for(typename StreamArray::iterator it=this->streams.begin();it != this->streams.end();it++)
+            if(queue.push(ts, std::forward<Args>(args)...))
+                return true;
+
+            if(this->overflow_policy == BLOCK)
             {
-                delete *it;
+                queue_waits.fetch_add(1, std::memory_order_relaxed);
+
+                /** the arguments are only consumed by a successful push **/
+                std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() +
+                    std::chrono::microseconds(this->block_timeout.toMicroseconds());
+
+                std::unique_lock<std::mutex> lock(room_mutex);
+                blocked_producers.fetch_add(1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                bool pushed = false;
+                do
+                {
+                    pushed = queue.push(ts, std::forward<Args>(args)...);
+                }
+                while(!pushed && room.wait_until(lock, deadline) == std::cv_status::no_timeout);
+                if(!pushed)
+                    pushed = queue.push(ts, std::forward<Args>(args)...);
+                blocked_producers.fetch_sub(1, std::memory_order_relaxed);
+                if(pushed)
+                    return true;
             }
+
+            queue_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
         }
+    };
 
-        /** will take the state of other StreamAligner and make it the state of this 
-         * object. State constitutes current_time and latest_time as well as all the stream
-         * content, but not the configuration.
+    /**
+     * ConcurrentStreamHandle
+     *
+     * @brief Typed reference to a ConcurrentStream
+     *
+     * It can be used as a StreamHandle by the thread running the aligner,
+     * and with StreamAligner::pushConcurrent() by any thread.
+     *
+     * */
+    template <class T, size_t BUFFER_SIZE, size_t QUEUE_SIZE>
+    class ConcurrentStreamHandle : public StreamHandle<T, BUFFER_SIZE>
+    {
+    public:
+        typedef ConcurrentStream<T, BUFFER_SIZE, QUEUE_SIZE> concurrent_stream_type;
+
+        concurrent_stream_type *concurrent_stream;
+
+    public:
+        ConcurrentStreamHandle() : concurrent_stream(NULL) {}
+
+        ConcurrentStreamHandle(int index, concurrent_stream_type *stream) :
+            StreamHandle<T, BUFFER_SIZE>(index, stream), concurrent_stream(stream) {}
+    };
+
+    /**
+     * Stream Aligner
+     *
+     * @brief Alignment of streams
+     *
+     * NUMBER_STREAMS is the maximum number of streams. With NUMBER_STREAMS
+     * equal to 0 (DynamicStreamAligner), the number of streams is not bounded
+     * and the per-stream storage grows on registration.
+     *
+     */
+    template<size_t NUMBER_STREAMS>
+    class StreamAligner
+    {
+
+    protected:
+	    typedef typename StreamStorage<StreamBase*, NUMBER_STREAMS>::type StreamArray;
+        template <size_t N> using StreamStatusArray = StreamAlignerStatus<N>; //alias template
+
+    protected:
+
+        /** The streams **/
+        StreamArray streams;
+
+        /** The timeout **/
+        ticks_t timeout;
+
+        /** time of the last sample that came in */
+        ticks_t latest_ts;
+
+        /** time of the last sample that went out */
+        ticks_t current_ts;
+
+        /** next timestamps of the streams, cached so that the stream
+         * selection does not need to go through the virtual interface */
+        StreamSelector<NUMBER_STREAMS> selector;
+
+        /** temporary object that gets returned by getStatus, 
+         * in order to avoid dynamic allocation on each call */
+	    mutable StreamStatusArray<NUMBER_STREAMS> status;
+
+        /** Moves the queued samples of a ConcurrentStream into its buffer **/
+        struct Ingestor
+        {
+            void (StreamAligner::*ingest)(int idx);
+            int idx;
+        };
+
+        /** the concurrent streams, in the first ingestors_count elements **/
+        typename StreamStorage<Ingestor, NUMBER_STREAMS>::type ingestors;
+        size_t ingestors_count;
+
+        /** unused slots of a dynamically sized aligner, the lowest index
+         * last **/
+        std::vector<int> free_slots;
+
+        /** memory shared by the stream buffers allowed to grow **/
+        ChunkPool buffer_pool;
+
+        /** the synchronizers, fed by the streams released in time order **/
+        std::vector<SynchronizerBase*> synchronizers;
+
+        /** set by the producers when samples got queued on a concurrent
+         * stream */
+        std::atomic<bool> ingest_pending;
+
+        /** records the input of the aligner, NULL if not recording **/
+        StreamRecorder *recorder;
+
+        /** gives the status to monitoring threads, NULL if not set **/
+        StatusPublisher<NUMBER_STREAMS> *publisher;
+
+    protected:
+        /** Moves the samples queued by the producers in the buffers of the
+         * concurrent streams. Called by the thread running the aligner
+         */
+        void ingest()
+        {
+            if(!ingest_pending.exchange(false, std::memory_order_acquire))
+                return;
+
+            for(size_t i = 0; i < ingestors_count; i++)
+            {
+                (this->*ingestors[i].ingest)(ingestors[i].idx);
+            }
+        }
+
+        template <class T, size_t BUFFER_SIZE, size_t QUEUE_SIZE> void ingestStream(int idx)
+        {
+            ConcurrentStream<T, BUFFER_SIZE, QUEUE_SIZE> *stream =
+                static_cast<ConcurrentStream<T, BUFFER_SIZE, QUEUE_SIZE>*>(this->streams[idx]);
+
+            /** account for the samples the producers could not queue **/
+            size_t dropped = stream->queue_dropped.exchange(0, std::memory_order_relaxed);
+            stream->status.samples_received += dropped;
+            stream->status.samples_dropped_queue_full += dropped;
+            stream->status.samples_blocked += stream->queue_waits.exchange(0, std::memory_order_relaxed);
+
+            /** with the BLOCK policy, samples stay in the queue while the
+             * buffer is full, so that the producers wait **/
+            bool block = stream->getOverflowPolicy() == BLOCK;
+
+            typename ConcurrentStream<T, BUFFER_SIZE, QUEUE_SIZE>::item sample;
+            bool received = false;
+            while(!(block && stream->isFull()) && stream->queue.pop(sample))
+            {
+                if(recorder)
+                    recorder->push(idx, sample.first, sample.second);
+                if( acceptSample(*stream, toTicks(sample.first)) )
+                    stream->push(sample.first, std::move(sample.second));
+                received = true;
+            }
+
+            if(block)
+            {
+                if(received)
+                    stream->notifyRoom();
+                if(stream->queue.size())
+                    ingest_pending.store(true, std::memory_order_relaxed);
+            }
+
+            if(received)
+                updateStreamOrder(idx);
+        }
+
+        /** Updates the ordering of the stream with the given index.
+         *
+         * Needs to be called whenever the stream state changes (push, pop,
+         * activation, registration)
+         */
+        void updateStreamOrder(int idx)
+        {
+            StreamBase *stream = this->streams[idx];
+            if(!stream)
+                selector.remove(idx);
+            else if(stream->hasData())
+                selector.setData(idx, stream->latestTimeStamp(), stream->getPriority());
+            else if(stream->isActive())
+                selector.setWaiting(idx, stream->latestTimeStamp(), stream->getPriority());
+            else
+                selector.remove(idx);
+        }
+
+        /** Reorders all the streams. */
+        void updateStreamOrder()
+        {
+            for(size_t i = 0; i < this->streams.size(); i++)
+            {
+                updateStreamOrder(i);
+            }
+        }
+
+        /** Gets the oldest and newest data times used for the timeout */
+        void timeoutWindow(ticks_t &firstDataTime, ticks_t &latestDataTime) const
+        {
+            /** initalization case **/
+            if(current_ts == 0)
+            {
+                /** check if one stream timed out **/
+                for(typename StreamArray::const_iterator it=streams.begin();it != streams.end();it++)
+                {
+                    if(*it && (*it)->hasData())
+                    {
+                        if(latestDataTime < (*it)->latestDataTime())
+                            latestDataTime = (*it)->latestDataTime();
+
+                        if(firstDataTime == 0 || firstDataTime > (*it)->earliestDataTime())
+                            firstDataTime = (*it)->earliestDataTime();
+                    }
+                }
+
+                /** the latest time might have been advanced without data **/
+                if(latestDataTime < latest_ts)
+                    latestDataTime = latest_ts;
+            }
+            else
+            {
+                latestDataTime = latest_ts;
+                firstDataTime = current_ts;
+            }
+        }
+
+        /** @return true if the time difference between the oldest and
+         * newest data reached the timeout */
+        bool timedOut() const
+        {
+            ticks_t latestDataTime = 0;
+            ticks_t firstDataTime = 0;
+            timeoutWindow(firstDataTime, latestDataTime);
+
+            return !(latestDataTime - firstDataTime < timeout);
+        }
+
+        /** @return the latest time from which on timedOut() is true */
+        ticks_t timeoutTime() const
+        {
+            ticks_t latestDataTime = 0;
+            ticks_t firstDataTime = 0;
+            timeoutWindow(firstDataTime, latestDataTime);
+
+            return firstDataTime + timeout;
+        }
+
+        /** @return the index of the stream whose oldest sample should be
+         * given to its callback next, or -1 if no sample can be released yet
+         */
+        int nextReleasable() const
+        {
+            /** stream with the oldest data **/
+            int next = selector.nextData();
+            if(next == -1)
+                return -1;
+
+            /** an active stream expects data before it **/
+            if(selector.nextWaitingTime() < selector.dataTime(next))
+            {
+                /** if there is no data, but the expected data has
+                not run out yet, wait for it. **/
+                if(!timedOut())
+                    return -1;
+            }
+            return next;
+        }
+
+        /** Updates the statistics for a sample pushed on the given stream
+         *
+         * @return false if the sample has to be dropped because it arrived
+         * later than the last sample given to a callback
+         */
+        bool acceptSample(StreamBase &stream, ticks_t ts)
+        {
+            stream.status.samples_received++;
+            stream.status.latest_sample_time = fromTicks(ts);
+
+            // mark stream as active, since it is receiving data items will
+            // have no effect on an already active stream, but enables
+            // streams which have been marked passive before.
+            stream.setActive( true );
+
+            //any sample, that is older than the last replayed sample
+            //will never be played back and gets dropped by default
+            if(ts < current_ts) 
+            {
+                this->status.samples_dropped_late_arriving++;
+                stream.status.samples_dropped_late_arriving++;
+                return false;
+            }
+
+            if( ts > latest_ts )
+                latest_ts = ts;
+
+            if( stream.decimate(ts) )
+            {
+                stream.status.samples_dropped_decimation++;
+                return false;
+            }
+
+            return true;
+        }
+
+        /** Sets the number of samples the stream with the given index
+         * receives during the timeout in its status */
+        void updateRequiredBufferSize(int idx)
+        {
+            StreamBase *stream = this->streams[idx];
+            stream->status.buffer_size_required = samplesInTimeout(stream->getPeriod().toMicroseconds(), timeout);
+        }
+
+        /** @return the first free slot of a fixed size aligner, -1 if full */
+        int allocateSlot(std::false_type)
+        {
+            for(size_t i = 0; i < this->streams.size(); i++)
+            {
+                if(!this->streams[i])
+                    return i;
+            }
+            return -1;
+        }
+
+        /** @return a free slot of a dynamically sized aligner, the storage of
+         * all streams is extended if there is none */
+        int allocateSlot(std::true_type)
+        {
+            if(!free_slots.empty())
+            {
+                int idx = free_slots.back();
+                free_slots.pop_back();
+                return idx;
+            }
+
+            size_t idx = this->streams.size();
+            StreamStorage<StreamBase*, NUMBER_STREAMS>::resize(this->streams, idx + 1, NULL);
+            StreamStorage<Ingestor, NUMBER_STREAMS>::resize(this->ingestors, idx + 1);
+            StreamStorage<StreamStatus, NUMBER_STREAMS>::resize(this->status.streams, idx + 1);
+            selector.resize(idx + 1);
+            return idx;
+        }
+
+        void releaseSlot(int, std::false_type)
+        {
+        }
+
+        void releaseSlot(int idx, std::true_type)
+        {
+            free_slots.insert(std::upper_bound(free_slots.begin(), free_slots.end(), idx, std::greater<int>()), idx);
+        }
+
+        /** @return the index of a free stream slot
+         * @throw std::runtime_error if all slots are used */
+        int allocateSlot()
+        {
+            int idx = allocateSlot(std::integral_constant<bool, StreamStorage<StreamBase*, NUMBER_STREAMS>::dynamic>());
+            if(idx == -1)
+                throw std::runtime_error("Array of streams is FULL");
+            return idx;
+        }
+
+        /** Moves the samples queued on the concurrent streams in their
+         * buffers between two releases. Not while recording: the pushes
+         * would be logged after the event of the current call, and be
+         * missing when it is replayed */
+        void ingestBetweenReleases()
+        {
+            if(!recorder)
+                ingest();
+        }
+
+        /** Releases samples until none can be released, or at most
+         * max_samples got released. Implements stepN() and drain(), the
+         * callers ingest before */
+        size_t releaseN(size_t max_samples)
+        {
+            size_t count = 0;
+            int next;
+            while(count < max_samples && (next = nextReleasable()) != -1)
+            {
+                release(next);
+                count++;
+                ingestBetweenReleases();
+            }
+            return count;
+        }
+
+        /** Gives the oldest sample of the given stream to its callback */
+        void release(int idx)
+        {
+            current_ts = this->streams[idx]->pop();
+            updateStreamOrder(idx);
+
+            for(size_t i = 0; i < synchronizers.size(); i++)
+            {
+                synchronizers[i]->update(fromTicks(current_ts));
+            }
+        }
+
+        /** Makes the stream give its samples to the synchronizer, as the
+         * stream of index I of the synchronizer */
+        template <size_t I, class S, class T, size_t BUFFER_SIZE> static void connectSynchronizer(S *synchronizer, const StreamHandle<T, BUFFER_SIZE> &handle)
+        {
+            /** the synchronizer takes the samples over, they are moved out
+             * of slots released right after **/
+            handle.stream->setSink([synchronizer](const base::Time &ts, T &value)
+            {
+                synchronizer->template collect<I>(ts, std::move(value));
+            });
+        }
+
+        template <class S, size_t... I, class... Handles> static void connectSynchronizer(S *synchronizer, IndexSequence<I...>, const Handles&... handles)
+        {
+            int expand[] = { 0, (connectSynchronizer<I>(synchronizer, handles), 0)... };
+            (void)expand;
+        }
+
+    public:
+    	explicit StreamAligner(base::Time timeout = base::Time::fromSeconds(1)): timeout(toTicks(timeout)), latest_ts(0), current_ts(0)
+        {
+            for(size_t i = 0; i < this->streams.size(); i++)
+            {
+                this->streams[i] = NULL;
+            }
+            ingestors_count = 0;
+            ingest_pending.store(false);
+            recorder = NULL;
+            publisher = NULL;
+        }
+
+        virtual ~StreamAligner()
+        {
+    	    for(typename StreamArray::iterator it=this->streams.begin();it != this->streams.end();it++)
+            {
+                delete *it;
+            }
+
+            for(size_t i = 0; i < synchronizers.size(); i++)
+            {
+                delete synchronizers[i];
+            }
+        }
+
+        /** will take the state of other StreamAligner and make it the state of this 
+         * object. State constitutes current_time and latest_time as well as all the stream
+         * content, but not the configuration.
+         */
+        void copyState(const StreamAligner<NUMBER_STREAMS>& other)
+        {
+            latest_ts = other.latest_ts;
+            current_ts = other.current_ts;
+
+            if(this->streams.size() != other.streams.size())
+            {
+                throw std::runtime_error("Stream setup of second stream aligner differs");
+            }
+
+            for(size_t i=0;i<this->streams.size();i++)
+            {
+                bool weGotStream = this->streams[i];
+                bool otherGotStream = other.streams[i];
+                if(weGotStream != otherGotStream)
+                {
+                    throw std::runtime_error("Stream setup of second stream aligner differs");
+                }
+
+                if(this->streams[i])
+                {
+                    this->streams[i]->copyState( *other.streams[i] );
+                }
+            }
+            updateStreamOrder();
+        }
+
+        /** Tells the aligner that the given time has been reached, even if
+         * no sample that recent came in.
+         *
+         * Streams waiting for data time out once the time advanced by more
+         * than the timeout, as if a newer sample had been pushed. This is
+         * meant to drive the timeout from a clock when the streams stop
+         * receiving data. Does nothing if the time is older than the latest
+         * time.
+         */
+        void advanceTime(const base::Time &time)
+        {
+            if(recorder)
+                recorder->advanceTime(time);
+
+            ticks_t ticks = toTicks(time);
+            if( ticks > latest_ts )
+                latest_ts = ticks;
+        }
+
+        /** Set the time the Estimator will wait for an expected reading on any of the streams.
+         * This number effectively puts an upper limit to the lag that can be created due to 
+         * delay or missing values on the channels.
+         */
+        void setTimeout(const base::Time &t)
+        {
+            timeout = toTicks(t);
+            for(size_t i = 0; i < this->streams.size(); i++)
+            {
+                if(this->streams[i])
+                    updateRequiredBufferSize(i);
+            }
+        }
+
+        /** Checks that the buffer of each stream holds the samples it
+         * receives during the timeout, given its period. The buffer sizes
+         * can be computed at compile time with bufferSize().
+         *
+         * Streams whose buffer can grow or spill, and aperiodic streams,
+         * are not checked.
+         *
+         * @throw std::runtime_error naming the first stream whose buffer is
+         * too small
+         */
+        void checkBufferSizes() const
+        {
+            for(size_t i = 0; i < this->streams.size(); i++)
+            {
+                const StreamBase *stream = this->streams[i];
+                if(!stream || !stream->isBounded())
+                    continue;
+
+                const StreamStatus &status(stream->getBufferStatus());
+                if(status.buffer_size < status.buffer_size_required)
+                {
+                    std::ostringstream message;
+                    message << "the buffer of stream " << i << " (" << status.name << ") holds "
+                        << status.buffer_size << " samples, its period and the timeout require "
+                        << status.buffer_size_required;
+                    throw std::runtime_error(message.str());
+                }
+            }
+        }
+
+        /** 
+         * Will disable the stream with the given index.  
+         *
+         * All data left in the stream will still be played out, however the
+         * stream will be ignored for lookahead and timeout calculation. A
+         * stream, which is disabled can be enabled through the enableStream()
+         * call, or if new data in this stream arrives.
+         *
+         * The functionality is needed for cases where streams might be
+         * optional, so that the other streams won't be delayed up to the
+         * maximum time out value.
+         */
+        void disableStream(int idx)
+        {
+            if(!this->streams[idx])
+            throw std::runtime_error("invalid stream index.");		
+
+            if(recorder)
+                recorder->disableStream(idx);
+
+            this->streams[idx]->setActive( false );
+            updateStreamOrder(idx);
+        }
+
+        /** 
+         * Enables a stream which has been disabled previously. 
+         *
+         * All streams are enabled by default. Does not have any effect on
+         * streams which are already enabled.
+         */
+        void enableStream(int idx)
+        {
+            if(!this->streams[idx])
+            throw std::runtime_error("invalid stream index.");		
+
+            if(recorder)
+                recorder->enableStream(idx);
+
+            this->streams[idx]->setActive( true );
+            updateStreamOrder(idx);
+        }
+
+        /** 
+         * See if a stream is enabled or disabled.
+         *
+         * @return true if the stream is enabled (active)
+         */
+        bool isStreamActive(int idx) const 
+        {
+            if(!this->streams[idx])
+                throw std::runtime_error("invalid stream index.");		
+
+            return this->streams[idx]->isActive();
+        }
+
+        /**
+         * Sets how late a sample may arrive on the stream with the given
+         * index, compared to the newest sample of that stream, and still be
+         * played in order.
+         *
+         * Samples older than the newest one are dropped by default and
+         * counted in samples_backward_in_time. Samples within the window are
+         * inserted at their place in the stream buffer instead (binary search
+         * over the buffered samples), and counted in samples_reordered.
+         * Samples older than the aligner current time are still dropped as
+         * late arriving.
+         */
+        void setReorderWindow(int idx, const base::Time &window)
+        {
+            if(!this->streams[idx])
+            throw std::runtime_error("invalid stream index.");
+
+            this->streams[idx]->setReorderWindow(window);
+        }
+
+        /**
+         * Keeps only one sample out of keep_every on the stream with the
+         * given index, the others are dropped when they are pushed and
+         * counted in samples_dropped_decimation. 1 keeps all samples.
+         */
+        void setDecimation(int idx, size_t keep_every)
+        {
+            if(!this->streams[idx])
+            throw std::runtime_error("invalid stream index.");
+
+            this->streams[idx]->setDecimation(keep_every);
+        }
+
+        /**
+         * Keeps at most one sample per min_interval on the stream with the
+         * given index, the others are dropped when they are pushed and
+         * counted in samples_dropped_decimation. A null interval disables
+         * the rate limit.
+         *
+         * Applied after setDecimation(). The period of the stream should
+         * match the resulting rate.
+         */
+        void setRateLimit(int idx, const base::Time &min_interval)
+        {
+            if(!this->streams[idx])
+            throw std::runtime_error("invalid stream index.");
+
+            this->streams[idx]->setRateLimit(min_interval);
+        }
+
+        /**
+         * Sets what the stream with the given index does with a new sample
+         * when its buffer is full (and cannot grow). The dropped samples are
+         * counted in samples_dropped_buffer_full.
+         *
+         * Only the branch taken on a full buffer depends on the policy, so
+         * the default OVERWRITE_OLDEST has no cost. Must be set before
+         * producers push on a concurrent stream.
+         *
+         * @param policy - the overflow policy
+         * @param block_timeout - with BLOCK, how long a producer calling
+         * pushConcurrent() waits for room in the queue. Samples waiting in
+         * the queue are only moved to the buffer once it has room. The waits
+         * are counted in samples_blocked.
+         */
+        void setOverflowPolicy(int idx, OverflowPolicy policy, const base::Time &block_timeout = base::Time())
+        {
+            if(!this->streams[idx])
+            throw std::runtime_error("invalid stream index.");
+
+            this->streams[idx]->setOverflowPolicy(policy, block_timeout);
+        }
+
+        /**
+         * Configures the memory pool shared by the growable stream buffers.
+         *
+         * @param chunk_size - size in bytes of the chunks the buffers grow by
+         * @param max_chunks - maximum number of chunks for all the streams
          */
-        void copyState(const StreamAligner<NUMBER_STREAMS>& other)
+        void setBufferPool(size_t chunk_size, size_t max_chunks)
         {
-            latest_ts = other.latest_ts;
-            current_ts = other.current_ts;
+            buffer_pool.configure(chunk_size, max_chunks);
+        }
 
-            assert( this->streams.size() == other.streams.size() );
-            for(size_t i=0;i<this->streams.size();i++)
-            {
-                bool weGotStream = this->streams[i];
-                bool otherGotStream = other.streams[i];
-                if(weGotStream != otherGotStream)
-                {
-                    throw std::runtime_error("Stream setup of second stream aligner differs");
-                }
+        /** @return the memory pool shared by the growable stream buffers */
+        const ChunkPool &getBufferPool() const { return buffer_pool; }
 
-                if(this->streams[i])
-                {
-                    this->streams[i]->copyState( *other.streams[i] );
-                }
-            }
+        /**
+         * Lets the buffer of the stream with the given index grow when it is
+         * full.
+         *
+         * Instead of dropping the oldest samples, the buffer grows by chunks
+         * taken from the buffer pool, and gives them back as it drains. This
+         * absorbs transient stalls without sizing the buffer for the worst
+         * case. Samples are only dropped once the pool is exhausted.
+         */
+        void enableBufferGrowth(int idx)
+        {
+            if(!this->streams[idx])
+            throw std::runtime_error("invalid stream index.");
+
+            this->streams[idx]->setBufferPool(&buffer_pool);
         }
 
-        /** Set the time the Estimator will wait for an expected reading on any of the streams.
-         * This number effectively puts an upper limit to the lag that can be created due to 
-         * delay or missing values on the channels.
+        /**
+         * Stops the buffer of the stream with the given index from growing.
+         * Samples already stored in chunks are still played out.
          */
-        void setTimeout(const base::Time &t)
+        void disableBufferGrowth(int idx)
         {
-            timeout = t;
+            if(!this->streams[idx])
+            throw std::runtime_error("invalid stream index.");
+
+            this->streams[idx]->setBufferPool(NULL);
         }
 
-        /** 
-         * Will disable the stream with the given index.  
+        /**
+         * Lets the stream with the given index write the samples which do
+         * not fit in its buffer (and buffer pool, if it can grow) to a
+         * memory-mapped file, instead of dropping them. They are read back
+         * in order as the buffer drains, so that a stalled consumer does not
+         * lose data while memory stays bounded.
          *
-         * All data left in the stream will still be played out, however the
-         * stream will be ignored for lookahead and timeout calculation. A
-         * stream, which is disabled can be enabled through the enableStream()
-         * call, or if new data in this stream arrives.
+         * Samples are serialized with SampleSerializer. Once the file reached
+         * max_size, the overflow policy of the stream applies, except that
+         * the oldest samples are not overwritten. Samples arriving out of
+         * order are not reordered once the stream spills, they are dropped.
          *
-         * The functionality is needed for cases where streams might be
-         * optional, so that the other streams won't be delayed up to the
-         * maximum time out value.
+         * @param directory - directory to create the file in, under a unique
+         * name. The file is removed from the file system as soon as it is
+         * opened
+         * @param max_size - maximum size of the file in bytes
+         * @throw std::runtime_error if the samples of the stream cannot be
+         * serialized or if the file cannot be created
          */
-        void disableStream(int idx)
+        void enableSpill(int idx, const std::string &directory, size_t max_size = size_t(1) << 30)
         {
             if(!this->streams[idx])
-            throw std::runtime_error("invalid stream index.");		
+            throw std::runtime_error("invalid stream index.");
 
-            this->streams[idx]->setActive( false );
+            if(!this->streams[idx]->canSerialize())
+                throw std::runtime_error("no SampleSerializer for the samples of the stream.");
+
+            this->streams[idx]->setSpillFile(new SpillFile(directory, max_size));
         }
 
-        /** 
-         * Enables a stream which has been disabled previously. 
+        /**
+         * Stops the stream with the given index from spilling and closes its
+         * file.
          *
-         * All streams are enabled by default. Does not have any effect on
-         * streams which are already enabled.
+         * @throw std::runtime_error if samples are still in the file
          */
-        void enableStream(int idx)
+        void disableSpill(int idx)
         {
             if(!this->streams[idx])
-            throw std::runtime_error("invalid stream index.");		
+            throw std::runtime_error("invalid stream index.");
 
-            this->streams[idx]->setActive( true );
+            this->streams[idx]->setSpillFile(NULL);
         }
 
-        /** 
-         * See if a stream is enabled or disabled.
+        /**
+         * Measures the time the samples of the stream with the given index
+         * spend in the aligner, from the push to the callback, in a log-scale
+         * histogram of fixed size. The percentiles are reported in the
+         * time_in_buffer fields of the stream status.
          *
-         * @return true if the stream is enabled (active)
+         * This costs a clock reading on each push and each release. For a
+         * concurrent stream, the time starts when the sample is ingested.
          */
-        bool isStreamActive(int idx) const 
+        void enableLatencyHistogram(int idx)
         {
             if(!this->streams[idx])
-                throw std::runtime_error("invalid stream index.");		
+            throw std::runtime_error("invalid stream index.");
 
-            return this->streams[idx]->isActive();
+            this->streams[idx]->setLatencyTracking(true);
+        }
+
+        void disableLatencyHistogram(int idx)
+        {
+            if(!this->streams[idx])
+            throw std::runtime_error("invalid stream index.");
+
+            this->streams[idx]->setLatencyTracking(false);
+        }
+
+        /** @return the histogram of the time the samples of the stream with
+         * the given index spent in the aligner, NULL if it is not enabled */
+        const LatencyHistogram *getLatencyHistogram(int idx) const
+        {
+            if(!this->streams.at(idx))
+            throw std::runtime_error("invalid stream index.");
+
+            return this->streams[idx]->getLatencyHistogram();
         }
 
         /**
@@ -381,6 +1652,17 @@ namespace stream_aligner
             delete this->streams[idx];
 
             this->streams[idx] = NULL;
+            updateStreamOrder(idx);
+            releaseSlot(idx, std::integral_constant<bool, StreamStorage<StreamBase*, NUMBER_STREAMS>::dynamic>());
+
+            for(size_t i = 0; i < ingestors_count; i++)
+            {
+                if(ingestors[i].idx == idx)
+                {
+                    ingestors[i] = ingestors[--ingestors_count];
+                    break;
+                }
+            }
 
             this->status.streams[idx].active = false;
         }
@@ -402,19 +1684,96 @@ namespace stream_aligner
          */
         template <class T, size_t BUFFER_SIZE> int registerStream( typename Stream<T, BUFFER_SIZE>::callback_t callback, base::Time period, int priority  = -1, const std::string &name = std::string())
         {
-            StreamBase *newStream = new Stream<T, BUFFER_SIZE>(callback, period, priority, name);
+            return registerStreamHandle<T, BUFFER_SIZE>(callback, period, priority, name).index;
+        }
 
-            /** Store the stream in the first free slot **/
-            for(size_t i = 0; i < this->streams.size(); i++)
-            {
-                if(!this->streams[i])
-                {
-                    this->streams[i] = newStream;
-                    this->status.streams[i] = StreamStatus();
-                    return i;
-                }
-            }
-            throw std::runtime_error("Array of streams is FULL");
+        /** Will register a stream with the stream_aligner.
+         *
+         * Same as registerStream(), but returns a typed handle on the stream
+         * instead of the stream index. Pushing through the handle avoids the
+         * lookup and the dynamic_cast of push(int, ...).
+         *
+         * @result - handle of the stream, valid until the stream is unregistered
+         */
+        template <class T, size_t BUFFER_SIZE> StreamHandle<T, BUFFER_SIZE> registerStreamHandle( typename Stream<T, BUFFER_SIZE>::callback_t callback, base::Time period, int priority  = -1, const std::string &name = std::string())
+        {
+            int i = allocateSlot();
+            Stream<T, BUFFER_SIZE> *newStream = new Stream<T, BUFFER_SIZE>(callback, period, priority, name);
+            this->streams[i] = newStream;
+            this->status.streams[i] = StreamStatus();
+            if(publisher)
+                publisher->setName(i, name);
+            updateRequiredBufferSize(i);
+            updateStreamOrder(i);
+            return StreamHandle<T, BUFFER_SIZE>(i, newStream);
+        }
+
+        /** Will register a stream which can be fed from other threads.
+         *
+         * Parameters are the same as registerStream(). Samples pushed with
+         * pushConcurrent() are queued in a lock-free queue of QUEUE_SIZE
+         * elements (a power of two), and moved to the stream buffer by the
+         * next call to step(), stepN(), stepUntil() or drain(). All other
+         * methods of the aligner must be called from a single thread.
+         *
+         * @result - handle of the stream, valid until the stream is unregistered
+         */
+        template <class T, size_t BUFFER_SIZE, size_t QUEUE_SIZE> ConcurrentStreamHandle<T, BUFFER_SIZE, QUEUE_SIZE> registerConcurrentStream( typename Stream<T, BUFFER_SIZE>::callback_t callback, base::Time period, int priority  = -1, const std::string &name = std::string())
+        {
+            int i = allocateSlot();
+            ConcurrentStream<T, BUFFER_SIZE, QUEUE_SIZE> *newStream = new ConcurrentStream<T, BUFFER_SIZE, QUEUE_SIZE>(callback, period, priority, name);
+            this->streams[i] = newStream;
+            this->status.streams[i] = StreamStatus();
+            if(publisher)
+                publisher->setName(i, name);
+            updateRequiredBufferSize(i);
+            updateStreamOrder(i);
+
+            Ingestor ingestor = { &StreamAligner::template ingestStream<T, BUFFER_SIZE, QUEUE_SIZE>, i };
+            this->ingestors[ingestors_count++] = ingestor;
+            return ConcurrentStreamHandle<T, BUFFER_SIZE, QUEUE_SIZE>(i, newStream);
+        }
+
+        /** Will register a synchronizer on a set of streams.
+         *
+         * The samples of the given streams are not given to the stream
+         * callbacks anymore, but collected by the synchronizer as they are
+         * released. The synchronizer gives tuples with one sample of each
+         * stream, whose times are at most tolerance apart, to its callback.
+         * Samples which do not match are dropped.
+         *
+         * @param callback - called with the times and the samples of a tuple
+         * @param tolerance - maximum time between the samples of a tuple
+         * @param handles - the streams, in the order of the tuple
+         *
+         * @result - the synchronizer, owned by the aligner. Gives access to
+         * its statistics.
+         */
+        template <size_t SYNC_BUFFER_SIZE, class... T, size_t... BUFFER_SIZE> Synchronizer<SYNC_BUFFER_SIZE, T...> *registerSynchronizer( typename Synchronizer<SYNC_BUFFER_SIZE, T...>::callback_t callback, const base::Time &tolerance, const StreamHandle<T, BUFFER_SIZE>&... handles )
+        {
+            Synchronizer<SYNC_BUFFER_SIZE, T...> *synchronizer = new Synchronizer<SYNC_BUFFER_SIZE, T...>(callback, tolerance);
+            synchronizers.push_back(synchronizer);
+            connectSynchronizer(synchronizer, typename MakeIndexSequence<sizeof...(T)>::type(), handles...);
+            return synchronizer;
+        }
+
+        /** @brief Push new data into a concurrent stream
+         *
+         * Thread-safe and lock-free: can be called by any thread, concurrently
+         * with the thread running the aligner. The sample is only seen by the
+         * aligner on its next step.
+         *
+         * @param handle - handle returned by registerConcurrentStream()
+         * @param ts - the timestamp of the data item
+         * @param data - the data added to the stream
+         * @return false if the stream queue was full and the sample got
+         * dropped (counted in samples_dropped_queue_full)
+         */
+        template <class T, size_t BUFFER_SIZE, size_t QUEUE_SIZE, class Data> bool pushConcurrent( const ConcurrentStreamHandle<T, BUFFER_SIZE, QUEUE_SIZE> &handle, const base::Time &ts, Data&& data )
+        {
+            bool queued = handle.concurrent_stream->ingest(ts, std::forward<Data>(data));
+            ingest_pending.store(true, std::memory_order_release);
+            return queued;
         }
 
         /** @brief Push new data into the stream
@@ -426,37 +1785,181 @@ namespace stream_aligner
          * @param data - the data added to the stream
          */
         template <class T, size_t BUFFER_SIZE> void push( int idx, const base::Time &ts, const T& data )
+        {
+            push(getStreamHandle<T, BUFFER_SIZE>(idx), ts, data);
+        }
+
+        /** @overload moves the data into the stream buffer
+         */
+        template <class T, size_t BUFFER_SIZE> void push( int idx, const base::Time &ts, T&& data )
+        {
+            push(getStreamHandle<T, BUFFER_SIZE>(idx), ts, std::move(data));
+        }
+
+        /** @brief Push new data into the stream referred by the handle
+         *
+         * @param handle - handle returned by registerStreamHandle()
+         * @param ts - the timestamp of the data item
+         * @param data - the data added to the stream
+         */
+        template <class T, size_t BUFFER_SIZE> void push( const StreamHandle<T, BUFFER_SIZE> &handle, const base::Time &ts, const typename StreamHandle<T, BUFFER_SIZE>::value_type& data )
+        {
+            if( recorder )
+                recorder->push(handle.index, ts, data);
+            if( acceptSample(*handle.stream, toTicks(ts)) )
+                handle.stream->push(ts, data);
+            updateStreamOrder(handle.index);
+        }
+
+        /** @overload moves the data into the stream buffer
+         */
+        template <class T, size_t BUFFER_SIZE> void push( const StreamHandle<T, BUFFER_SIZE> &handle, const base::Time &ts, typename StreamHandle<T, BUFFER_SIZE>::value_type&& data )
+        {
+            if( recorder )
+                recorder->push(handle.index, ts, data);
+            if( acceptSample(*handle.stream, toTicks(ts)) )
+                handle.stream->push(ts, std::move(data));
+            updateStreamOrder(handle.index);
+        }
+
+        /** @brief Construct new data in the stream
+         *
+         * Same as push(), but the data item is constructed from the given
+         * arguments. Nothing is constructed if the sample gets dropped.
+         *
+         * @param ts - the timestamp of the data item
+         * @param args - the constructor arguments of the data item
+         */
+        template <class T, size_t BUFFER_SIZE, class... Args> void emplace( int idx, const base::Time &ts, Args&&... args )
+        {
+            emplace(getStreamHandle<T, BUFFER_SIZE>(idx), ts, std::forward<Args>(args)...);
+        }
+
+        /** @overload
+         */
+        template <class T, size_t BUFFER_SIZE, class... Args> void emplace( const StreamHandle<T, BUFFER_SIZE> &handle, const base::Time &ts, Args&&... args )
+        {
+            /** the recorder needs the sample to serialize it **/
+            if( recorder )
+            {
+                T data(std::forward<Args>(args)...);
+                push(handle, ts, std::move(data));
+                return;
+            }
+
+            if( acceptSample(*handle.stream, toTicks(ts)) )
+                handle.stream->emplace(ts, std::forward<Args>(args)...);
+            updateStreamOrder(handle.index);
+        }
+
+        /** @brief Push data serialized with SampleSerializer into the stream
+         * with the given index, without knowing its type. Used to replay
+         * recorded data.
+         */
+        void pushSerialized( int idx, const base::Time &ts, const char *data, size_t size )
         {
             if( !this->streams.at(idx) )
                 throw std::runtime_error("invalid stream index.");
 
-            Stream<T, BUFFER_SIZE>* stream = dynamic_cast<Stream<T, BUFFER_SIZE>*>(this->streams[idx]);
-            assert( stream );
+            if( recorder )
+                recorder->pushSerialized(idx, ts, data, size);
 
-            stream->status.samples_received++;
-            stream->status.latest_sample_time = ts;
+            if( acceptSample(*this->streams[idx], toTicks(ts)) )
+                this->streams[idx]->pushSerialized(ts, data, size);
+            updateStreamOrder(idx);
+        }
 
-            // mark stream as active, since it is receiving data items will
-            // have no effect on an already active stream, but enables
-            // streams which have been marked passive before.
-            stream->setActive( true );
+        /**
+         * Records the input of the aligner into the given recorder: the
+         * samples, as they get pushed or ingested, and the calls to step(),
+         * stepN(), stepUntil(), drain(), advanceTime(), clear(),
+         * enableStream() and disableStream(). StreamReplayer plays it back.
+         * The configuration of the aligner is not recorded.
+         *
+         * While recording, the samples of the concurrent streams are
+         * ingested once at the beginning of each of these calls, so that
+         * they are logged before it. Samples the producers queue during a
+         * call wait for the next one.
+         *
+         * @param recorder - the recorder, which must outlive the recording.
+         * NULL stops recording.
+         * @throw std::runtime_error if the samples of a registered stream
+         * cannot be serialized
+         */
+        void setRecorder(StreamRecorder *recorder)
+        {
+            if(recorder)
+            {
+                for(size_t i = 0; i < this->streams.size(); i++)
+                {
+                    if(this->streams[i] && !this->streams[i]->canSerialize())
+                        throw std::runtime_error("no SampleSerializer for the samples of stream " + this->streams[i]->getBufferStatus().name);
+                }
+            }
+            this->recorder = recorder;
+        }
 
-            //any sample, that is older than the last replayed sample
-            //will never be played back and gets dropped by default
-            if(ts < current_ts) 
+        StreamRecorder *getRecorder() const { return recorder; }
+
+        /**
+         * Sets the publisher through which publishStatus() makes the status
+         * available to other threads. The names of the registered streams
+         * are interned in the publisher now, the names of the streams
+         * registered later when they are registered.
+         *
+         * @param publisher - the publisher, which must outlive the aligner
+         * or be unset. NULL unsets it.
+         */
+        void setStatusPublisher(StatusPublisher<NUMBER_STREAMS> *publisher)
+        {
+            if(publisher)
             {
-                this->status.samples_dropped_late_arriving++;
-                stream->status.samples_dropped_late_arriving++;
-                return;
+                for(size_t i = 0; i < this->streams.size(); i++)
+                {
+                    if(this->streams[i])
+                        publisher->setName(i, this->streams[i]->getBufferStatus().name);
+                }
             }
+            this->publisher = publisher;
+        }
 
-            if( ts > latest_ts )
-                latest_ts = ts;
+        StatusPublisher<NUMBER_STREAMS> *getStatusPublisher() const { return publisher; }
+
+        /**
+         * Writes the current status into the status publisher, from which
+         * monitoring threads read it without locking the aligner. Unlike
+         * getStatus(), it neither allocates nor copies the stream names, and
+         * does not block: call it from the thread running the aligner, at
+         * the rate the status is monitored at.
+         *
+         * Does nothing if no publisher is set. Streams with an index past
+         * the capacity of the publisher are not published.
+         */
+        void publishStatus()
+        {
+            if(!publisher)
+                return;
 
-            stream->push(ts, data);
+            StatusSnapshot<NUMBER_STREAMS> &snapshot(publisher->prepare());
+            snapshot.time = base::Time::now();
+            snapshot.current_time = fromTicks(current_ts);
+            snapshot.latest_time = fromTicks(latest_ts);
+            snapshot.samples_dropped_late_arriving = this->status.samples_dropped_late_arriving;
+            snapshot.stream_count = std::min<size_t>(streams.size(), publisher->getCapacity());
+
+            for(size_t i = 0; i < snapshot.stream_count; i++)
+            {
+                if(streams[i])
+                    snapshot.streams[i].assign(streams[i]->getBufferStatus(), publisher->getName(i));
+                else
+                    snapshot.streams[i] = StreamSnapshot();
+            }
+            publisher->publish();
         }
 
-        template <class T, size_t BUFFER_SIZE> bool getNextSample( int idx, std::pair<base::Time,T> &sample) const
+        /** @return a typed handle on the stream with the given index
+         */
+        template <class T, size_t BUFFER_SIZE> StreamHandle<T, BUFFER_SIZE> getStreamHandle( int idx ) const
         {
             if( !this->streams.at(idx) )
                 throw std::runtime_error("invalid stream index.");
@@ -464,7 +1967,33 @@ namespace stream_aligner
             Stream<T, BUFFER_SIZE>* stream = dynamic_cast<Stream<T, BUFFER_SIZE>*>(this->streams[idx]);
             assert( stream );
 
-            return stream->getNextSample(sample);
+            return StreamHandle<T, BUFFER_SIZE>(idx, stream);
+        }
+
+        template <class T, size_t BUFFER_SIZE> bool getNextSample( int idx, std::pair<base::Time,T> &sample) const
+        {
+            return getNextSample(getStreamHandle<T, BUFFER_SIZE>(idx), sample);
+        }
+
+        template <class T, size_t BUFFER_SIZE> bool getNextSample( const StreamHandle<T, BUFFER_SIZE> &handle, std::pair<base::Time,T> &sample) const
+        {
+            return handle.stream->getNextSample(sample);
+        }
+
+        /** Gives access to the next sample of a stream, without copying it
+         *
+         * @param ts - set to the time of the sample
+         * @return the sample, or NULL if the stream has no data. The pointer
+         * is valid until the sample is given to the stream's callback.
+         */
+        template <class T, size_t BUFFER_SIZE> const T* peekNextSample( int idx, base::Time &ts) const
+        {
+            return peekNextSample(getStreamHandle<T, BUFFER_SIZE>(idx), ts);
+        }
+
+        template <class T, size_t BUFFER_SIZE> const T* peekNextSample( const StreamHandle<T, BUFFER_SIZE> &handle, base::Time &ts) const
+        {
+            return handle.stream->peekNextSample(ts);
         }
 
         /** This will go through the available streams and look for the
@@ -485,58 +2014,105 @@ namespace stream_aligner
          */
         bool step()
         {
-            /** copy streams vector and sort it by next ts **/
-            StreamArray items = this->streams;
-            std::sort(items.begin(), items.end(), &compareStreams);
+            /** the pushes ingested are logged before the step **/
+            ingest();
 
-            for(typename StreamArray::iterator it=items.begin();it != items.end();it++)
-            {
-                /** first stream is unregistered no data there **/
-                if(!*it)
-                    return false;
+            if(recorder)
+                recorder->step();
 
-                if((*it)->hasData()) 
-                {
-                    /** if stream has current data, pop that data **/
-                    current_ts = (*it)->pop();
-                    return true;
-                }
-                else if( (*it)->isActive() )
-                {
-                    base::Time latestDataTime;
-                    base::Time firstDataTime;
+            int next = nextReleasable();
+            if(next == -1)
+                return false;
 
-                    /** initalization case **/
-                    if(current_ts == base::Time())
-                    {
-                        /** check if one stream timed out **/
-                        for(typename StreamArray::iterator it2=items.begin();it2 != items.end();it2++)
-                        {
-                            if(*it2 && (*it2)->hasData())
-                            {
-                                if(latestDataTime < (*it2)->latestDataTime())
-                                    latestDataTime = (*it2)->latestDataTime();
-
-                                if(firstDataTime == base::Time() || firstDataTime > (*it2)->earliestDataTime())
-                                    firstDataTime = (*it2)->earliestDataTime();
-                            }
-                        }			
-                    }
-                    else
-                    {
-                        latestDataTime = latest_ts;
-                        firstDataTime = current_ts;
-                    }
+            release(next);
+            return true;
+        }
 
-                    if(latestDataTime - firstDataTime < timeout)
-                    {
-                        /** if there is no data, but the expected data has
-                        not run out yet, wait for it. **/
-                        return false;
-                    }
-                }
+        /** Calls step() until no more data can be released, or at most
+         * max_samples samples got released.
+         *
+         * @result - the number of samples given to the callbacks
+         */
+        size_t stepN(size_t max_samples)
+        {
+            ingest();
+
+            if(recorder)
+                recorder->stepN(max_samples);
+
+            return releaseN(max_samples);
+        }
+
+        /** Releases all samples which can be released and have a timestamp
+         * lower or equal than the given time.
+         *
+         * @result - the number of samples given to the callbacks
+         */
+        size_t stepUntil(const base::Time &time)
+        {
+            ingest();
+
+            if(recorder)
+                recorder->stepUntil(time);
+
+            ticks_t until = toTicks(time);
+            size_t count = 0;
+            int next;
+            while((next = nextReleasable()) != -1 && !(until < selector.dataTime(next)))
+            {
+                release(next);
+                count++;
+                ingestBetweenReleases();
             }
-            return false;
+            return count;
+        }
+
+        /** Releases all samples which can currently be released. Equivalent
+         * to calling step() until it returns false.
+         *
+         * @result - the number of samples given to the callbacks
+         */
+        size_t drain()
+        {
+            ingest();
+
+            if(recorder)
+                recorder->drain();
+
+            return releaseN(std::numeric_limits<size_t>::max());
+        }
+
+        /** Tells whether step() can make progress, without side effects.
+         *
+         * @result - true if a sample can be released, or if samples were
+         * queued on a concurrent stream since the last step
+         */
+        bool isReady() const
+        {
+            return ingest_pending.load(std::memory_order_acquire) || nextReleasable() != -1;
+        }
+
+        /** Computes the time from which on step() can make progress, without
+         * side effects. This is a data time, to be compared with the
+         * timestamps of the samples.
+         *
+         * @result
+         *  - getLatestTime() if isReady() is true.
+         *  - the time at which the streams waiting for data time out if
+         *    samples are waiting for them. step() makes progress once a sample
+         *    that recent is pushed, or the time is advanced with advanceTime().
+         *  - base::Time::max() if no sample is waiting. Only a push can
+         *    make progress possible.
+         */
+        base::Time nextReleaseTime() const
+        {
+            if(isReady())
+                return fromTicks(latest_ts);
+
+            if(!selector.hasData())
+                return base::Time::max();
+
+            return fromTicks(timeoutTime());
         }
 
         /**
@@ -546,6 +2122,13 @@ namespace stream_aligner
          */
         void clear()
         {
+            /** samples still queued by the producers are discarded as well **/
+            ingest_pending.store(true);
+            ingest();
+
+            if(recorder)
+                recorder->clear();
+
             for(size_t i = 0; i < streams.size(); i++)
             {
                 if(streams[i])
@@ -554,8 +2137,14 @@ namespace stream_aligner
                 }
             }
 
-            latest_ts = base::Time();
-            current_ts = base::Time();
+            latest_ts = 0;
+            current_ts = 0;
+            updateStreamOrder();
+
+            for(size_t i = 0; i < synchronizers.size(); i++)
+            {
+                synchronizers[i]->clear();
+            }
 
             this->status.current_time = base::Time();
             this->status.latest_time = base::Time();
@@ -566,22 +2155,22 @@ namespace stream_aligner
          * This number effectively puts an upper limit to the lag that can be created due to 
          * delay or missing values on the channels.
          */
-        base::Time getTimeOut() const { return timeout; };
+        base::Time getTimeOut() const { return fromTicks(timeout); };
 
         /** latency is the time difference between the latest data item that
          * has come in, and the latest data item that went out
          */
-        base::Time getLatency() const { return latest_ts - current_ts; };
+        base::Time getLatency() const { return fromTicks(latest_ts - current_ts); };
 
         /** return the time of the last data item that went out
          */
-        base::Time getCurrentTime() const { return current_ts; };
+        base::Time getCurrentTime() const { return fromTicks(current_ts); };
 
         /** return the time of the last data item that came in
          */
-        base::Time getLatestTime() const { return latest_ts; }
+        base::Time getLatestTime() const { return fromTicks(latest_ts); }
 
-        /** return the number of streams 
+        /** return the number of stream slots, registered or not
         */
         int getStreamSize() const { return streams.size();  } 
 
@@ -617,6 +2206,10 @@ namespace stream_aligner
     };
 
 
+    /** StreamAligner whose number of streams is set at runtime **/
+    typedef StreamAligner<0> DynamicStreamAligner;
+
+
     template <size_t N> inline std::ostream &operator<<(std::ostream &stream, const stream_aligner::StreamAligner<N> &re)
     {
         using ::operator <<;
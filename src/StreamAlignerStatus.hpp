@@ -1,6 +1,8 @@
 #ifndef STREAM_ALIGNER_STREAM_ALIGNER_STATUS_HPP
 #define STREAM_ALIGNER_STREAM_ALIGNER_STATUS_HPP
 
+#include <stream_aligner/StreamStorage.hpp>
+
 #include <base/Time.hpp>
 #include <array>
 
@@ -11,8 +13,14 @@ namespace stream_aligner
     class StreamStatus
     {
     public:
-        /** The actual size of the buffer */
+        /** The actual size of the buffer, including the chunks it grew by */
         size_t buffer_size;
+        /** How many samples the stream receives during the aligner timeout,
+         * given its period. A buffer smaller than that, which cannot grow,
+         * drops samples when another stream times out. 0 for aperiodic
+         * streams. @see StreamAligner::checkBufferSizes
+         */
+        size_t buffer_size_required;
         /** How many samples are currently waiting inside the stream buffer */
         size_t buffer_fill;
         /** The total number of samples ever received for that stream
@@ -21,25 +29,70 @@ namespace stream_aligner
          *   
          *   samples_received == samples_processed +
          * 	samples_dropped_buffer_full +
-         * 	samples_dropped_late_arriving
+         * 	samples_dropped_late_arriving +
+         * 	samples_dropped_queue_full +
+         * 	samples_dropped_decimation
          */
         size_t samples_received;
         /** The total count of samples ever processed by the callbacks of this stream
          * 
          * The total number of samples ever received is
          *   
-         *   samples_processed + samples_dropped_buffer_full + samples_dropped_late_arriving
+         *   samples_processed + samples_dropped_buffer_full + samples_dropped_late_arriving +
+         *   samples_dropped_queue_full + samples_dropped_decimation
          */
         size_t samples_processed;
         /** Count of samples dropped because the buffer was full
          * 
-         * Should be zero on streams that have dynamically resized buffers
+         * Should be zero on streams that have dynamically resized buffers,
+         * unless their chunk pool got exhausted
          */
         size_t samples_dropped_buffer_full;
         /** Count of samples dropped because their timestamp was earlier than
          * the stream aligner current time
          */
         size_t samples_dropped_late_arriving;
+        /** Count of samples dropped because the ingestion queue of a
+         * concurrent stream was full
+         */
+        size_t samples_dropped_queue_full;
+        /** Count of samples dropped by the decimation or the rate limit of
+         * the stream
+         */
+        size_t samples_dropped_decimation;
+        /** Count of samples whose producer had to wait for room in the
+         * queue of a concurrent stream (BLOCK overflow policy). They are
+         * counted in samples_dropped_queue_full if the wait timed out
+         */
+        size_t samples_blocked;
+        /** Count of samples older than the previous sample of the stream,
+         * inserted at their place because they were within the reorder
+         * window. They are also counted as received and processed
+         */
+        size_t samples_reordered;
+        /** Count of chunks the buffer grew by because it was full
+         */
+        size_t buffer_growths;
+        /** Count of chunks the buffer gave back after draining
+         *
+         * buffer_growths - buffer_shrinks is the number of chunks in use
+         */
+        size_t buffer_shrinks;
+        /** Count of samples written to the spill file because the buffer was
+         * full. They are read back in order as the buffer drains
+         */
+        size_t samples_spilled;
+        /** Number of samples currently in the spill file. They are included
+         * in buffer_fill
+         */
+        size_t spill_fill;
+        /** Median, 99th percentile and maximum of the time samples spent in
+         * the buffer, from the push to the callback. Null unless the latency
+         * histogram of the stream is enabled
+         */
+        base::Time time_in_buffer_p50;
+        base::Time time_in_buffer_p99;
+        base::Time time_in_buffer_max;
         /** Count of samples dropped because their timestamp was not properly ordered
          * 
          * I.e. samples for which the timestamp was later than the previous
@@ -71,9 +124,12 @@ namespace stream_aligner
         int64_t priority;
 
     public:
-        StreamStatus() : buffer_size(0), buffer_fill(0), samples_received(0), 
+        StreamStatus() : buffer_size(0), buffer_size_required(0), buffer_fill(0), samples_received(0), 
                 samples_processed(0), samples_dropped_buffer_full(0), 
-                samples_dropped_late_arriving(0), 
+                samples_dropped_late_arriving(0), samples_dropped_queue_full(0),
+                samples_dropped_decimation(0), samples_blocked(0),
+                samples_reordered(0), buffer_growths(0), buffer_shrinks(0),
+                samples_spilled(0), spill_fill(0),
                 samples_backward_in_time(0), active(true), priority(0)
         {
         }
@@ -82,12 +138,14 @@ namespace stream_aligner
     /** Structure used to report the complete state of a stream aligner
      * 
      * The stream aligner latency is time - current_time
+     *
+     * NUMBER_STREAMS is 0 for a stream aligner sized at runtime
      */
     template<size_t NUMBER_STREAMS>
     class StreamAlignerStatus
     {
     public:
-        typedef std::array<StreamStatus, NUMBER_STREAMS> StatusVector;
+        typedef typename StreamStorage<StreamStatus, NUMBER_STREAMS>::type StatusVector;
 
     public:
 
@@ -146,7 +204,7 @@ template <size_t NUMBER_STREAMS> inline std::ostream &operator<<(std::ostream &o
     if( status.streams.empty() )
     	return os; 
 
-    os << "idx\tname\t\tbsize\tbfill\treceived\tprocessed\tdr_bfull\tdr_late\tbackward time" << std::endl;
+    os << "idx\tname\t\tbsize\tbfill\treceived\tprocessed\tdr_bfull\tdr_late\tdr_queue\tdr_decim\tblocked\tgrowths\tspilled\tbackward time" << std::endl;
 
     int cnt = 0;
     for(typename stream_aligner::StreamAlignerStatus<NUMBER_STREAMS>::StatusVector::const_iterator it = status.streams.begin(); it != status.streams.end(); it++)
@@ -161,13 +219,18 @@ template <size_t NUMBER_STREAMS> inline std::ostream &operator<<(std::ostream &o
         	<< it->samples_processed << "\t"
         	<< it->samples_dropped_buffer_full << "\t"
         	<< it->samples_dropped_late_arriving << "\t"
+        	<< it->samples_dropped_queue_full << "\t"
+        	<< it->samples_dropped_decimation << "\t"
+        	<< it->samples_blocked << "\t"
+        	<< it->buffer_growths << "\t"
+        	<< it->samples_spilled << "\t"
         	<< it->samples_backward_in_time << "\t"
         	<< std::endl;
         }
 	cnt++;
     }
 
-    os << "idx\tname\t\tlatest sample\tearliers data\tlatest data\tlatency" << std::endl;
+    os << "idx\tname\t\tlatest sample\tearliers data\tlatest data\tlatency\tin buffer p50\tp99\tmax" << std::endl;
 
     for(typename stream_aligner::StreamAlignerStatus<NUMBER_STREAMS>::StatusVector::const_iterator it = status.streams.begin(); it != status.streams.end(); it++)
     {
@@ -177,7 +240,10 @@ template <size_t NUMBER_STREAMS> inline std::ostream &operator<<(std::ostream &o
                 << it->latest_sample_time << "\t"
                 << it->earliest_data_time << " \t "
                 << it->latest_data_time << " \t "
-                << it->latest_sample_time - status.current_time
+                << it->latest_sample_time - status.current_time << " \t "
+                << it->time_in_buffer_p50 << " \t "
+                << it->time_in_buffer_p99 << " \t "
+                << it->time_in_buffer_max
                 << std::endl;
             }
         cnt++;
@@ -0,0 +1,213 @@
+#ifndef STREAM_ALIGNER_STREAM_RECORDER_HPP
+#define STREAM_ALIGNER_STREAM_RECORDER_HPP
+
+#include <stream_aligner/SampleSerializer.hpp>
+
+#include <base/Time.hpp>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stream_aligner
+{
+    /** @brief Recording format of the StreamRecorder
+     *
+     *  A log starts with MAGIC and VERSION, followed by events. Each event
+     *  is a one byte type followed by its arguments, in native byte order
+     *  and without padding:
+     *  - PUSH: int32 stream index, int64 time in microseconds, uint64 payload
+     *    size and the payload, serialized with SampleSerializer
+     *  - STEP, DRAIN, CLEAR: no argument
+     *  - STEP_N: uint64 maximum number of samples
+     *  - STEP_UNTIL, ADVANCE_TIME: int64 time in microseconds
+     *  - ENABLE_STREAM, DISABLE_STREAM: int32 stream index
+     */
+    namespace record
+    {
+        static const char MAGIC[8] = { 'S', 'A', 'L', 'I', 'G', 'N', 'L', 'G' };
+        static const uint32_t VERSION = 1;
+
+        enum EventType
+        {
+            PUSH = 1,
+            STEP,
+            STEP_N,
+            STEP_UNTIL,
+            DRAIN,
+            ADVANCE_TIME,
+            CLEAR,
+            ENABLE_STREAM,
+            DISABLE_STREAM
+        };
+    }
+
+    /** @brief StreamRecorder
+     *
+     *  Writes a compact binary log of what is fed into a StreamAligner: the
+     *  pushed samples, in the order they enter the aligner, and the calls
+     *  releasing samples or changing the time. StreamReplayer feeds a log
+     *  back into an aligner set up the same way, which then releases the
+     *  same samples in the same order.
+     *
+     *  Set with StreamAligner::setRecorder(). Samples pushed from other
+     *  threads on concurrent streams are recorded when the aligner ingests
+     *  them. The recorder is not thread-safe, it is used from the thread
+     *  running the aligner.
+     */
+    class StreamRecorder
+    {
+    protected:
+        std::FILE *file;
+
+        /** serialized payload of the sample being recorded **/
+        std::vector<char> payload;
+
+        size_t events;
+
+        void write(const void *data, size_t size)
+        {
+            if (std::fwrite(data, 1, size, this->file) != size)
+                throw std::runtime_error(std::string("stream recorder: write failed: ") + std::strerror(errno));
+        }
+
+        void writeEvent(record::EventType type)
+        {
+            uint8_t value = type;
+            this->write(&value, sizeof(value));
+            this->events++;
+        }
+
+        void writeTime(const base::Time &time)
+        {
+            int64_t value = time.toMicroseconds();
+            this->write(&value, sizeof(value));
+        }
+
+        void writeIndex(int idx)
+        {
+            int32_t value = idx;
+            this->write(&value, sizeof(value));
+        }
+
+    public:
+        /** @brief Constructor
+         *
+         *  @param path file to write the log to. An existing file is
+         *  overwritten
+         *  @throw std::runtime_error if the file cannot be created
+         */
+        explicit StreamRecorder(const std::string &path)
+            : file(std::fopen(path.c_str(), "wb")), events(0)
+        {
+            if (!this->file)
+                throw std::runtime_error("stream recorder: cannot create " + path + ": " + std::strerror(errno));
+
+            /** events are small, write them in large blocks **/
+            std::setvbuf(this->file, NULL, _IOFBF, 1 << 20);
+
+            this->write(record::MAGIC, sizeof(record::MAGIC));
+            this->write(&record::VERSION, sizeof(record::VERSION));
+        }
+
+        StreamRecorder(const StreamRecorder &other) = delete;
+        StreamRecorder& operator=(const StreamRecorder &other) = delete;
+
+        ~StreamRecorder()
+        {
+            std::fclose(this->file);
+        }
+
+        /** @brief records a sample pushed on the stream with the given index
+         *
+         *  @throw std::runtime_error if T has no SampleSerializer
+         */
+        template <class T>
+        void push(int idx, const base::Time &ts, const T &value)
+        {
+            if (!SampleSerializer<T>::supported)
+                throw std::runtime_error("stream recorder: no SampleSerializer for the samples of a stream");
+
+            size_t size = SampleSerializer<T>::size(value);
+            if (this->payload.size() < size)
+                this->payload.resize(size);
+            SampleSerializer<T>::write(value, this->payload.data());
+
+            this->pushSerialized(idx, ts, this->payload.data(), size);
+        }
+
+        /** @brief records a sample already serialized
+         */
+        void pushSerialized(int idx, const base::Time &ts, const char *data, size_t size)
+        {
+            uint64_t value = size;
+            this->writeEvent(record::PUSH);
+            this->writeIndex(idx);
+            this->writeTime(ts);
+            this->write(&value, sizeof(value));
+            this->write(data, size);
+        }
+
+        void step()
+        {
+            this->writeEvent(record::STEP);
+        }
+
+        void stepN(size_t max_samples)
+        {
+            uint64_t value = max_samples;
+            this->writeEvent(record::STEP_N);
+            this->write(&value, sizeof(value));
+        }
+
+        void stepUntil(const base::Time &time)
+        {
+            this->writeEvent(record::STEP_UNTIL);
+            this->writeTime(time);
+        }
+
+        void drain()
+        {
+            this->writeEvent(record::DRAIN);
+        }
+
+        void advanceTime(const base::Time &time)
+        {
+            this->writeEvent(record::ADVANCE_TIME);
+            this->writeTime(time);
+        }
+
+        void clear()
+        {
+            this->writeEvent(record::CLEAR);
+        }
+
+        void enableStream(int idx)
+        {
+            this->writeEvent(record::ENABLE_STREAM);
+            this->writeIndex(idx);
+        }
+
+        void disableStream(int idx)
+        {
+            this->writeEvent(record::DISABLE_STREAM);
+            this->writeIndex(idx);
+        }
+
+        /** @brief writes the buffered events to the file
+         */
+        void flush()
+        {
+            if (std::fflush(this->file) != 0)
+                throw std::runtime_error(std::string("stream recorder: write failed: ") + std::strerror(errno));
+        }
+
+        /** @return the number of events recorded **/
+        size_t getEvents() const { return this->events; }
+    };
+}
+#endif
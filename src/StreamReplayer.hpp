@@ -0,0 +1,201 @@
+#ifndef STREAM_ALIGNER_STREAM_REPLAYER_HPP
+#define STREAM_ALIGNER_STREAM_REPLAYER_HPP
+
+#include <stream_aligner/StreamAligner.hpp>
+#include <stream_aligner/StreamRecorder.hpp>
+
+#include <base/Time.hpp>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace stream_aligner
+{
+    /** @brief StreamReplayer
+     *
+     *  Plays a log written by a StreamRecorder back into a StreamAligner, as
+     *  fast as possible. The log is memory-mapped, and the samples are
+     *  deserialized straight from the mapping.
+     *
+     *  The aligner must be configured as the recorded one: same streams
+     *  registered at the same indices, same timeout and stream settings.
+     *  Since the log holds all the input of the aligner, including the calls
+     *  driving the time, it then releases the same samples in the same
+     *  order as during the recording.
+     */
+    class StreamReplayer
+    {
+    protected:
+        const char *data;
+        size_t size;
+
+        /** offset of the next event **/
+        size_t pos;
+
+        size_t events;
+
+        static size_t headerSize()
+        {
+            return sizeof(record::MAGIC) + sizeof(record::VERSION);
+        }
+
+        template <class V>
+        V read()
+        {
+            if (this->size - this->pos < sizeof(V))
+                throw std::runtime_error("stream replayer: truncated log");
+
+            V value;
+            std::memcpy(&value, this->data + this->pos, sizeof(V));
+            this->pos += sizeof(V);
+            return value;
+        }
+
+        base::Time readTime()
+        {
+            return base::Time::fromMicroseconds(this->read<int64_t>());
+        }
+
+    public:
+        /** @brief Constructor
+         *
+         *  @param path the log to replay
+         *  @throw std::runtime_error if the file cannot be mapped or is not a
+         *  log of a supported version
+         */
+        explicit StreamReplayer(const std::string &path)
+            : data(NULL), size(0), pos(0), events(0)
+        {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw std::runtime_error("stream replayer: cannot open " + path + ": " + std::strerror(errno));
+
+            struct stat info;
+            if (::fstat(fd, &info) != 0 || size_t(info.st_size) < headerSize())
+            {
+                ::close(fd);
+                throw std::runtime_error("stream replayer: " + path + " is not a stream aligner log");
+            }
+
+            void *data = ::mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (data == MAP_FAILED)
+                throw std::runtime_error("stream replayer: cannot map " + path + ": " + std::strerror(errno));
+
+            this->data = static_cast<const char*>(data);
+            this->size = info.st_size;
+
+            /** the log is read once, from the beginning to the end **/
+            ::madvise(data, this->size, MADV_SEQUENTIAL);
+
+            uint32_t version;
+            std::memcpy(&version, this->data + sizeof(record::MAGIC), sizeof(version));
+            if (std::memcmp(this->data, record::MAGIC, sizeof(record::MAGIC)) != 0 || version != record::VERSION)
+            {
+                ::munmap(data, this->size);
+                throw std::runtime_error("stream replayer: " + path + " is not a stream aligner log of a supported version");
+            }
+            this->rewind();
+        }
+
+        StreamReplayer(const StreamReplayer &other) = delete;
+        StreamReplayer& operator=(const StreamReplayer &other) = delete;
+
+        ~StreamReplayer()
+        {
+            ::munmap(const_cast<char*>(this->data), this->size);
+        }
+
+        /** @brief plays the next event back
+         *
+         *  @return false if all the events were played
+         *  @throw std::runtime_error if the log is malformed
+         */
+        template <size_t NUMBER_STREAMS>
+        bool replayNext(StreamAligner<NUMBER_STREAMS> &aligner)
+        {
+            if (this->atEnd())
+                return false;
+
+            switch (this->read<uint8_t>())
+            {
+                case record::PUSH:
+                {
+                    int idx = this->read<int32_t>();
+                    base::Time ts = this->readTime();
+                    uint64_t payload_size = this->read<uint64_t>();
+                    if (this->size - this->pos < payload_size)
+                        throw std::runtime_error("stream replayer: truncated log");
+
+                    aligner.pushSerialized(idx, ts, this->data + this->pos, payload_size);
+                    this->pos += payload_size;
+                    break;
+                }
+                case record::STEP:
+                    aligner.step();
+                    break;
+                case record::STEP_N:
+                    aligner.stepN(this->read<uint64_t>());
+                    break;
+                case record::STEP_UNTIL:
+                    aligner.stepUntil(this->readTime());
+                    break;
+                case record::DRAIN:
+                    aligner.drain();
+                    break;
+                case record::ADVANCE_TIME:
+                    aligner.advanceTime(this->readTime());
+                    break;
+                case record::CLEAR:
+                    aligner.clear();
+                    break;
+                case record::ENABLE_STREAM:
+                    aligner.enableStream(this->read<int32_t>());
+                    break;
+                case record::DISABLE_STREAM:
+                    aligner.disableStream(this->read<int32_t>());
+                    break;
+                default:
+                    throw std::runtime_error("stream replayer: unknown event in log");
+            }
+
+            this->events++;
+            return true;
+        }
+
+        /** @brief plays all the remaining events back
+         *
+         *  @return the number of events played
+         */
+        template <size_t NUMBER_STREAMS>
+        size_t replay(StreamAligner<NUMBER_STREAMS> &aligner)
+        {
+            size_t count = 0;
+            while (this->replayNext(aligner))
+                count++;
+            return count;
+        }
+
+        /** @brief restarts from the first event
+         */
+        void rewind()
+        {
+            this->pos = headerSize();
+            this->events = 0;
+        }
+
+        bool atEnd() const { return this->pos == this->size; }
+
+        /** @return the number of events played since the last rewind **/
+        size_t getEvents() const { return this->events; }
+    };
+}
+#endif
@@ -0,0 +1,245 @@
+#ifndef STREAM_ALIGNER_STREAM_SELECTOR_HPP
+#define STREAM_ALIGNER_STREAM_SELECTOR_HPP
+
+#include <stream_aligner/StreamStorage.hpp>
+#include <stream_aligner/Ticks.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace stream_aligner
+{
+    /** @brief StreamSelector
+     *
+     *  Selects the stream to release the next sample from, by scanning a
+     *  cache of the next timestamp of every stream, in ticks. The cache is
+     *  a structure of arrays: the timestamps of the streams with data and
+     *  of the streams waiting for data are in two contiguous arrays, where
+     *  the other streams have the value NONE.
+     *
+     *  The streams are grouped in blocks of BLOCK streams, whose minimum is
+     *  cached: updating a stream rescans its block, and selecting scans the
+     *  block minima, so that both are O(sqrt(N)) for the usual number of
+     *  streams. The scans are single passes with no branch nor
+     *  indirection over at most a few dozen entries, which the compiler
+     *  may vectorize when it targets a SIMD instruction set (e.g.
+     *  -march=native). Hand-written AVX2 and SSE4.2 scans were measured
+     *  slower than the scalar loops on scans this short.
+     *
+     *  Streams with the same timestamp are ordered by priority, then by
+     *  index: the rank of a stream holds both, so that the order is the
+     *  one of the (timestamp, rank) pairs.
+     *
+     *  With N equal to 0 the number of streams is set at runtime by
+     *  resize().
+     */
+    template <size_t N>
+    class StreamSelector
+    {
+    public:
+        static const ticks_t NONE = std::numeric_limits<ticks_t>::max();
+
+    protected:
+        /** timestamps per AVX2 vector, the arrays are padded to a multiple
+         * so that vectorized scans need no remainder loop **/
+        static const size_t LANES = 4;
+        /** streams per block, a multiple of LANES **/
+        static const size_t BLOCK = 16;
+        static const size_t PADDED_N = (N + LANES - 1) / LANES * LANES;
+        static const size_t PADDED_BLOCKS = ((PADDED_N + BLOCK - 1) / BLOCK + LANES - 1) / LANES * LANES;
+
+        enum State { EMPTY, DATA, WAITING };
+
+        typedef typename StreamStorage<int64_t, PADDED_N>::type TimeArray;
+        typedef typename StreamStorage<int64_t, PADDED_BLOCKS>::type BlockArray;
+
+        /** next timestamp of the streams with data, NONE for the others **/
+        TimeArray data_times;
+
+        /** expected timestamp of the active streams without data, NONE for
+         * the others **/
+        TimeArray waiting_times;
+
+        /** priority in the high 32 bits, index in the low 32 bits, NONE for
+         * the padding **/
+        TimeArray ranks;
+
+        /** smallest (data time, rank) pair and smallest waiting time of
+         * each block, NONE for the padding **/
+        BlockArray block_data_times;
+        BlockArray block_data_ranks;
+        BlockArray block_waiting_times;
+
+        typename StreamStorage<uint8_t, N>::type states;
+
+        size_t streams_count;
+        size_t data_count;
+
+        static int64_t rank(int idx, int priority)
+        {
+            return int64_t(priority) * (int64_t(1) << 32) + idx;
+        }
+
+        /** @return the minimum of the n first values */
+        static int64_t minimum(const int64_t *values, size_t n)
+        {
+            int64_t min = NONE;
+            for (size_t i = 0; i < n; ++i)
+                min = values[i] < min ? values[i] : min;
+            return min;
+        }
+
+        /** @return the rank of the smallest (time, rank) pair among the n
+         * first ones, and its time in min_time. NONE for both if all times
+         * are NONE */
+        static int64_t argminimum(const int64_t *times, const int64_t *ranks, size_t n, int64_t &min_time)
+        {
+            int64_t best_time = NONE, best_rank = NONE;
+            for (size_t i = 0; i < n; ++i)
+            {
+                if (times[i] < best_time || (times[i] == best_time && ranks[i] < best_rank))
+                {
+                    best_time = times[i];
+                    best_rank = ranks[i];
+                }
+            }
+            min_time = best_time;
+            return best_time == NONE ? NONE : best_rank;
+        }
+
+        size_t paddedSize() const
+        {
+            return (this->streams_count + LANES - 1) / LANES * LANES;
+        }
+
+        size_t paddedBlocks() const
+        {
+            return ((this->paddedSize() + BLOCK - 1) / BLOCK + LANES - 1) / LANES * LANES;
+        }
+
+        /** recomputes the minima of the block of the given stream **/
+        void updateBlock(int idx)
+        {
+            size_t block = idx / BLOCK;
+            size_t begin = block * BLOCK;
+            size_t n = this->paddedSize() - begin < BLOCK ? this->paddedSize() - begin : BLOCK;
+            this->block_data_ranks[block] = argminimum(this->data_times.data() + begin, this->ranks.data() + begin, n,
+                    this->block_data_times[block]);
+            this->block_waiting_times[block] = minimum(this->waiting_times.data() + begin, n);
+        }
+
+    public:
+        StreamSelector() : streams_count(N), data_count(0)
+        {
+            this->clear();
+        }
+
+        /** @brief removes all the streams */
+        void clear()
+        {
+            for (size_t i = 0; i < this->data_times.size(); ++i)
+            {
+                this->data_times[i] = NONE;
+                this->waiting_times[i] = NONE;
+                this->ranks[i] = i < this->streams_count ? rank(i, 0) : NONE;
+            }
+            for (size_t i = 0; i < this->block_data_times.size(); ++i)
+            {
+                this->block_data_times[i] = NONE;
+                this->block_data_ranks[i] = NONE;
+                this->block_waiting_times[i] = NONE;
+            }
+            for (size_t i = 0; i < this->states.size(); ++i)
+                this->states[i] = EMPTY;
+            this->data_count = 0;
+        }
+
+        /** @brief extends the range of stream indices to [0, n) */
+        void resize(size_t n)
+        {
+            if (n <= this->streams_count)
+                return;
+
+            size_t old_count = this->streams_count;
+            this->streams_count = n;
+            size_t padded = this->paddedSize();
+            StreamStorage<int64_t, PADDED_N>::resize(this->data_times, padded, NONE);
+            StreamStorage<int64_t, PADDED_N>::resize(this->waiting_times, padded, NONE);
+            StreamStorage<int64_t, PADDED_N>::resize(this->ranks, padded, NONE);
+            for (size_t i = old_count; i < n; ++i)
+                this->ranks[i] = rank(i, 0);
+            StreamStorage<uint8_t, N>::resize(this->states, n, EMPTY);
+
+            /** the new streams have no time, the minima of the blocks do
+             * not change **/
+            size_t blocks = this->paddedBlocks();
+            StreamStorage<int64_t, PADDED_BLOCKS>::resize(this->block_data_times, blocks, NONE);
+            StreamStorage<int64_t, PADDED_BLOCKS>::resize(this->block_data_ranks, blocks, NONE);
+            StreamStorage<int64_t, PADDED_BLOCKS>::resize(this->block_waiting_times, blocks, NONE);
+        }
+
+        /** @brief the stream has data, the oldest sample having the given
+         * timestamp */
+        void setData(int idx, ticks_t time, int priority)
+        {
+            if (this->states[idx] != DATA)
+                this->data_count++;
+            this->states[idx] = DATA;
+            this->data_times[idx] = time;
+            this->waiting_times[idx] = NONE;
+            this->ranks[idx] = rank(idx, priority);
+            this->updateBlock(idx);
+        }
+
+        /** @brief the stream has no data, and expects a sample with the
+         * given timestamp */
+        void setWaiting(int idx, ticks_t time, int priority)
+        {
+            if (this->states[idx] == DATA)
+                this->data_count--;
+            this->states[idx] = WAITING;
+            this->data_times[idx] = NONE;
+            this->waiting_times[idx] = time;
+            this->ranks[idx] = rank(idx, priority);
+            this->updateBlock(idx);
+        }
+
+        /** @brief the stream neither has data nor waits for data */
+        void remove(int idx)
+        {
+            if (this->states[idx] == DATA)
+                this->data_count--;
+            this->states[idx] = EMPTY;
+            this->data_times[idx] = NONE;
+            this->waiting_times[idx] = NONE;
+            this->updateBlock(idx);
+        }
+
+        bool hasData() const { return this->data_count != 0; }
+
+        /** @return the timestamp of the oldest sample of a stream with data */
+        ticks_t dataTime(int idx) const { return this->data_times[idx]; }
+
+        /** @return the stream with the oldest sample, -1 if no stream has
+         * data */
+        int nextData() const
+        {
+            if (!this->data_count)
+                return -1;
+            int64_t time;
+            int64_t best = argminimum(this->block_data_times.data(), this->block_data_ranks.data(), this->paddedBlocks(), time);
+            return best == NONE ? -1 : int(best & 0xffffffff);
+        }
+
+        /** @return the earliest timestamp expected by a stream waiting for
+         * data, NONE if no stream is waiting */
+        ticks_t nextWaitingTime() const
+        {
+            return minimum(this->block_waiting_times.data(), this->paddedBlocks());
+        }
+    };
+
+    template <size_t N> const ticks_t StreamSelector<N>::NONE;
+}
+#endif
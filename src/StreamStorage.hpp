@@ -0,0 +1,51 @@
+#ifndef STREAM_ALIGNER_STREAM_STORAGE_HPP
+#define STREAM_ALIGNER_STREAM_STORAGE_HPP
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace stream_aligner
+{
+    /** @brief StreamStorage
+     *
+     *  Selects the container holding one element per stream of a
+     *  stream aligner with N streams: a std::array when N is fixed at
+     *  compile time, a std::vector growing with the number of registered
+     *  streams when N is 0.
+     */
+    template <class T, size_t N>
+    struct StreamStorage
+    {
+        typedef std::array<T, N> type;
+
+        /** true if the container is sized at runtime **/
+        static const bool dynamic = false;
+
+        /** Makes the container hold at least n elements, new elements are
+         * set to value.
+         *
+         * @return false if the container cannot hold n elements
+         */
+        static bool resize(type &, size_t n, const T & = T())
+        {
+            return n <= N;
+        }
+    };
+
+    template <class T>
+    struct StreamStorage<T, 0>
+    {
+        typedef std::vector<T> type;
+
+        static const bool dynamic = true;
+
+        static bool resize(type &container, size_t n, const T &value = T())
+        {
+            if (container.size() < n)
+                container.resize(n, value);
+            return true;
+        }
+    };
+}
+#endif
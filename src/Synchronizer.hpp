@@ -0,0 +1,226 @@
+#ifndef STREAM_ALIGNER_SYNCHRONIZER_HPP
+#define STREAM_ALIGNER_SYNCHRONIZER_HPP
+
+#include <stream_aligner/CircularArray.hpp>
+#include <stream_aligner/IndexSequence.hpp>
+#include <stream_aligner/InplaceFunction.hpp>
+
+#include <base/Time.hpp>
+
+#include <array>
+#include <tuple>
+#include <utility>
+
+namespace stream_aligner
+{
+    /**
+     * SynchronizerBase
+     *
+     * @brief Base class of Synchronizer
+     *
+     * */
+    class SynchronizerBase
+    {
+    public:
+        virtual ~SynchronizerBase() {}
+
+        /** Matches the collected samples, knowing that no sample older than
+         * the given time can be collected anymore */
+        virtual void update(const base::Time &now) = 0;
+
+        /** Removes the collected samples */
+        virtual void clear() = 0;
+    };
+
+    /**
+     * Synchronizer
+     *
+     * @brief Approximate time synchronization of a set of streams
+     *
+     * Collects the samples of its member streams as the StreamAligner
+     * releases them, and gives tuples with one sample of each stream to its
+     * callback. The samples of a tuple are at most tolerance apart, and each
+     * tuple is the one with the minimum spread among the samples which can
+     * still be matched. Samples which cannot be part of any tuple are
+     * dropped.
+     *
+     * Since samples are released in time order, a tuple is given to the
+     * callback as soon as no sample coming later could give a better match.
+     *
+     * BUFFER_SIZE is the number of samples waiting for a match for each
+     * stream.
+     *
+     * */
+    template <size_t BUFFER_SIZE, class... T>
+    class Synchronizer : public SynchronizerBase
+    {
+    public:
+        static const size_t SIZE = sizeof...(T);
+
+        /** Times of the samples of a tuple, in the order of the streams */
+        typedef std::array<base::Time, SIZE> times_t;
+
+        /** Callback type, called with the times and the samples of a tuple */
+        typedef InplaceFunction<void (const times_t &ts, const T&... values)> callback_t;
+
+    protected:
+        typedef typename MakeIndexSequence<SIZE>::type indices_t;
+
+        callback_t callback;
+        base::Time tolerance;
+
+        /** times of the samples waiting for a match, for each stream **/
+        std::array<CircularArray<base::Time, BUFFER_SIZE>, SIZE> times;
+
+        /** samples waiting for a match, for each stream **/
+        std::tuple<CircularArray<T, BUFFER_SIZE>...> values;
+
+        size_t tuples_matched;
+        size_t samples_unmatched;
+        size_t samples_dropped_buffer_full;
+
+    protected:
+        /** removes the oldest sample of the given stream */
+        template <size_t... I> void drop(size_t idx, IndexSequence<I...>)
+        {
+            int expand[] = { 0, (I == idx ? (std::get<I>(values).pop_front(), 0) : 0)... };
+            (void)expand;
+            times[idx].pop_front();
+        }
+
+        /** gives the oldest sample of each stream to the callback and
+         * removes them */
+        template <size_t... I> void match(IndexSequence<I...>)
+        {
+            times_t ts = {{ times[I].front()... }};
+            if(callback)
+                callback(ts, std::get<I>(values).front()...);
+
+            int expand[] = { 0, (std::get<I>(values).pop_front(), times[I].pop_front(), 0)... };
+            (void)expand;
+            tuples_matched++;
+        }
+
+    public:
+        Synchronizer(callback_t callback, const base::Time &tolerance)
+            : callback(callback), tolerance(tolerance), tuples_matched(0),
+              samples_unmatched(0), samples_dropped_buffer_full(0)
+        {
+        }
+
+        /** Adds a sample released by the aligner on the stream of index I
+         * in the synchronizer. The sample is moved, the aligner hands its
+         * slot over (see Stream::setSink) */
+        template <size_t I> void collect(const base::Time &ts, typename std::tuple_element<I, std::tuple<T...> >::type &&value)
+        {
+            if(times[I].full())
+                samples_dropped_buffer_full++;
+
+            times[I].push_back(ts);
+            std::get<I>(values).push_back(std::move(value));
+        }
+
+        virtual void update(const base::Time &now)
+        {
+            while(true)
+            {
+                /** the oldest sample is matched first **/
+                size_t oldest = SIZE;
+                for(size_t i = 0; i < SIZE; i++)
+                {
+                    if(!times[i].empty() && (oldest == SIZE || times[i].front() < times[oldest].front()))
+                        oldest = i;
+                }
+                if(oldest == SIZE)
+                    return;
+
+                /** the tuple of the oldest samples has the smallest spread of
+                 * the tuples starting with the oldest sample **/
+                const base::Time first = times[oldest].front();
+                base::Time last = first;
+                base::Time others_first = base::Time::max();
+                bool complete = true;
+                for(size_t i = 0; i < SIZE; i++)
+                {
+                    if(i == oldest)
+                        continue;
+                    if(times[i].empty())
+                    {
+                        complete = false;
+                        continue;
+                    }
+                    if(last < times[i].front())
+                        last = times[i].front();
+                    if(times[i].front() < others_first)
+                        others_first = times[i].front();
+                }
+
+                if(!complete)
+                {
+                    /** samples still to come are not older than now **/
+                    if(now - first > tolerance)
+                    {
+                        drop(oldest, indices_t());
+                        samples_unmatched++;
+                        continue;
+                    }
+                    return;
+                }
+
+                const base::Time spread = last - first;
+                if(spread > tolerance)
+                {
+                    drop(oldest, indices_t());
+                    samples_unmatched++;
+                    continue;
+                }
+
+                /** the next sample of the same stream might give a tuple with
+                 * a smaller spread **/
+                if(times[oldest].size() > 1)
+                {
+                    const base::Time next = times[oldest].at(1);
+                    const base::Time next_last = last < next ? next : last;
+                    const base::Time next_first = next < others_first ? next : others_first;
+                    if(next_last - next_first < spread)
+                    {
+                        drop(oldest, indices_t());
+                        samples_unmatched++;
+                        continue;
+                    }
+                }
+                else if(now - others_first < spread)
+                {
+                    /** the next sample is not older than now, wait for it **/
+                    return;
+                }
+
+                match(indices_t());
+            }
+        }
+
+        virtual void clear()
+        {
+            for(size_t i = 0; i < SIZE; i++)
+            {
+                while(!times[i].empty())
+                    drop(i, indices_t());
+            }
+        }
+
+        /** @return the number of tuples given to the callback */
+        size_t getTuplesMatched() const { return tuples_matched; }
+
+        /** @return the number of samples which could not be matched */
+        size_t getSamplesUnmatched() const { return samples_unmatched; }
+
+        /** @return the number of samples dropped because too many samples
+         * were waiting for a match */
+        size_t getSamplesDroppedBufferFull() const { return samples_dropped_buffer_full; }
+
+        /** @return the number of samples of the stream of index idx
+         * waiting for a match */
+        size_t getSamplesWaiting(size_t idx) const { return times.at(idx).size(); }
+    };
+}
+#endif
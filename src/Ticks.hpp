@@ -0,0 +1,31 @@
+#ifndef STREAM_ALIGNER_TICKS_HPP
+#define STREAM_ALIGNER_TICKS_HPP
+
+#include <base/Time.hpp>
+
+#include <cstdint>
+
+namespace stream_aligner
+{
+    /** @brief Timestamps inside the aligners
+     *
+     *  The aligners take and return base::Time, but keep their times as
+     *  raw microseconds internally: the state of the streams and of the
+     *  timeout is compared and subtracted as plain integers, and arrays
+     *  of timestamps can be scanned with integer SIMD (see
+     *  StreamSelector). The conversions only happen where a time crosses
+     *  the public interface.
+     */
+    typedef int64_t ticks_t;
+
+    inline ticks_t toTicks(const base::Time &time)
+    {
+        return time.toMicroseconds();
+    }
+
+    inline base::Time fromTicks(ticks_t ticks)
+    {
+        return base::Time::fromMicroseconds(ticks);
+    }
+}
+#endif
@@ -41,15 +41,15 @@ namespace stream_aligner
         typedef boost::function<bool (base::Time&, T&)> pull_callback_t;
 
     protected:
-        int stream_idx;
+        StreamHandle<T, BUFFER_SIZE> stream_handle;
         StreamAligner<NUMBER_STREAMS> *sa;
 
         pull_callback_t pull_callback;
         T last_data;
 
     public:
-        PullStream( pull_callback_t pull_callback, StreamAligner<NUMBER_STREAMS>* sa, size_t stream_index )
-        : stream_idx( stream_index ), sa( sa ), pull_callback( pull_callback ) {}
+        PullStream( pull_callback_t pull_callback, StreamAligner<NUMBER_STREAMS>* sa, const StreamHandle<T, BUFFER_SIZE> &stream_handle )
+        : stream_handle( stream_handle ), sa( sa ), pull_callback( pull_callback ) {}
 
         void pull()
         {
@@ -59,7 +59,7 @@ namespace stream_aligner
         void push()
         {
         if( has_data )
-            sa->template push<T, BUFFER_SIZE>( stream_idx, last_ts, last_data );
+            sa->push( stream_handle, last_ts, last_data );
 
         has_data = false;	
         }
@@ -121,9 +121,9 @@ namespace stream_aligner
         int registerPullStream( typename PullStream<T, BUFFER_SIZE, NUMBER_STREAMS>::pull_callback_t pull_callback,
             typename Stream<T, BUFFER_SIZE>::callback_t callback, base::Time period, int priority  = -1 ) 
         {
-            int idx = this-> template registerStream<T, BUFFER_SIZE>(callback, period, priority);
-            this->pull_streams[idx] = new PullStream<T, BUFFER_SIZE, NUMBER_STREAMS>(pull_callback, this, idx);
-            return idx;
+            StreamHandle<T, BUFFER_SIZE> handle = this-> template registerStreamHandle<T, BUFFER_SIZE>(callback, period, priority);
+            this->pull_streams[handle.index] = new PullStream<T, BUFFER_SIZE, NUMBER_STREAMS>(pull_callback, this, handle);
+            return handle.index;
         }
 
         bool pull()
@@ -0,0 +1,78 @@
+#include <stream_aligner/StreamAligner.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+/** Measures the throughput of the spill path (samples written to the spill
+ * file while the consumer stalls) and of the read-back path (the stream
+ * draining from the file), for a range of payload sizes. **/
+
+/** Samples kept in memory before spilling **/
+#define BUFFER_SIZE 16
+
+/** Amount of data spilled for each payload size, in bytes **/
+#define SPILLED_BYTES (size_t(256) << 20)
+
+/** Directory the spill file is created in **/
+#define SPILL_DIRECTORY "."
+
+template <size_t SIZE>
+struct Payload
+{
+    char data[SIZE];
+};
+
+static double seconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <size_t SIZE>
+void benchmark()
+{
+    const size_t samples = SPILLED_BYTES / SIZE;
+
+    stream_aligner::StreamAligner<1> aligner;
+    aligner.setTimeout(base::Time());
+
+    size_t received = 0;
+    stream_aligner::StreamHandle< Payload<SIZE>, BUFFER_SIZE > handle = aligner.registerStreamHandle< Payload<SIZE>, BUFFER_SIZE >(
+            [&received](const base::Time &, const Payload<SIZE> &) { received++; },
+            base::Time::fromMicroseconds(1));
+    aligner.enableSpill(handle, SPILL_DIRECTORY, 2 * SPILLED_BYTES);
+
+    Payload<SIZE> payload;
+    std::memset(payload.data, 0x55, SIZE);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < samples; ++i)
+        aligner.push(handle, base::Time::fromMicroseconds(i + 1), payload);
+    double spill_time = seconds(start);
+
+    const stream_aligner::StreamStatus status = aligner.getBufferStatus(handle);
+
+    start = std::chrono::steady_clock::now();
+    aligner.drain();
+    double read_time = seconds(start);
+
+    if (received != samples || status.samples_dropped_buffer_full)
+        std::cout << "error: " << received << " samples out of " << samples << " played back" << std::endl;
+
+    double mbytes = double(samples * SIZE) / (1 << 20);
+    std::cout << SIZE << "\t" << samples << "\t" << status.samples_spilled << "\t"
+        << mbytes / spill_time << "\t" << samples / spill_time << "\t"
+        << mbytes / read_time << "\t" << samples / read_time << std::endl;
+}
+
+int main()
+{
+    std::cout << "payload\tsamples\tspilled\tspill MB/s\tspill samples/s\tread MB/s\tread samples/s" << std::endl;
+
+    benchmark<64>();
+    benchmark<1024>();
+    benchmark<16 * 1024>();
+    benchmark<64 * 1024>();
+
+    return 0;
+}
@@ -0,0 +1,260 @@
+#include <stream_aligner/StreamAligner.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+/** Measures the push, step and end-to-end throughput of the StreamAligner
+ * and the time samples spend in it, for a matrix of number of streams,
+ * buffer sizes, payload sizes and arrival patterns.
+ *
+ * The results are written to the standard output as CSV, one line per
+ * configuration, to be compared between builds. The optional argument is
+ * the number of samples pushed per configuration. **/
+
+/** Period of the streams in microseconds **/
+#define PERIOD 1000
+
+/** Samples pushed per configuration, by default **/
+#define SAMPLES 200000
+
+enum Pattern
+{
+    /** all streams deliver at their period, interleaved **/
+    PERIODIC,
+    /** each stream delivers its samples in bursts **/
+    BURSTY,
+    /** like PERIODIC, but the first stream stops after its first sample **/
+    STALLED
+};
+
+static const char *patternName(Pattern pattern)
+{
+    switch (pattern)
+    {
+        case PERIODIC: return "periodic";
+        case BURSTY: return "bursty";
+        case STALLED: return "stalled";
+    }
+    return "";
+}
+
+/** A sample: the time it got pushed, padded to SIZE bytes **/
+template <size_t SIZE>
+struct Payload
+{
+    int64_t pushed;
+    char data[SIZE - sizeof(int64_t)];
+};
+
+/** no padding, a zero-length array is not valid C++ **/
+template <>
+struct Payload<sizeof(int64_t)>
+{
+    int64_t pushed;
+};
+
+struct Arrival
+{
+    int stream;
+    base::Time ts;
+};
+
+static int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/** @return the samples in arrival order, the streams delivering burst
+ * samples at a time when the pattern is BURSTY */
+static std::vector<Arrival> arrivals(Pattern pattern, size_t streams, size_t burst, size_t samples)
+{
+    std::vector<Arrival> result;
+    const int64_t base = 1000000;
+    for (size_t round = 0; result.size() < samples; ++round)
+    {
+        for (size_t s = 0; s < streams; ++s)
+        {
+            for (size_t b = 0; b < burst; ++b)
+            {
+                size_t k = round * burst + b;
+                if (pattern == STALLED && s == 0 && k > 0)
+                    continue;
+
+                Arrival arrival;
+                arrival.stream = s;
+                arrival.ts = base::Time::fromMicroseconds(base + k * PERIOD + s * PERIOD / streams);
+                result.push_back(arrival);
+            }
+        }
+
+        /** the periodic streams deliver one sample each in turn **/
+        if (pattern != BURSTY)
+        {
+            std::stable_sort(result.end() - std::min(result.size(), streams * burst), result.end(),
+                    [](const Arrival &a, const Arrival &b) { return a.ts < b.ts; });
+        }
+    }
+    return result;
+}
+
+struct Results
+{
+    size_t released;
+    std::vector<int64_t> latencies;
+};
+
+template <size_t STREAMS, size_t BUFFER_SIZE, size_t PAYLOAD_SIZE>
+class Benchmark
+{
+    typedef Payload<PAYLOAD_SIZE> sample_t;
+
+    std::unique_ptr< stream_aligner::StreamAligner<STREAMS> > aligner;
+    std::vector< stream_aligner::StreamHandle<sample_t, BUFFER_SIZE> > handles;
+    Results results;
+
+public:
+    Benchmark(const base::Time &timeout, bool measure_latency)
+        : aligner(new stream_aligner::StreamAligner<STREAMS>(timeout))
+    {
+        results.released = 0;
+        Results *r = &results;
+        for (size_t s = 0; s < STREAMS; ++s)
+        {
+            if (measure_latency)
+                handles.push_back(aligner->template registerStreamHandle<sample_t, BUFFER_SIZE>(
+                            [r](const base::Time &, const sample_t &sample) { r->released++; r->latencies.push_back(now() - sample.pushed); },
+                            base::Time::fromMicroseconds(PERIOD)));
+            else
+                handles.push_back(aligner->template registerStreamHandle<sample_t, BUFFER_SIZE>(
+                            [r](const base::Time &, const sample_t &) { r->released++; },
+                            base::Time::fromMicroseconds(PERIOD)));
+        }
+    }
+
+    void push(const Arrival &arrival, sample_t &sample)
+    {
+        aligner->push(handles[arrival.stream], arrival.ts, sample);
+    }
+
+    stream_aligner::StreamAligner<STREAMS> &get() { return *aligner; }
+
+    Results &getResults() { return results; }
+
+    size_t dropped() const
+    {
+        size_t count = 0;
+        for (size_t s = 0; s < STREAMS; ++s)
+        {
+            const stream_aligner::StreamStatus &status(aligner->getBufferStatus(s));
+            count += status.samples_dropped_buffer_full + status.samples_dropped_late_arriving;
+        }
+        return count;
+    }
+};
+
+template <size_t STREAMS, size_t BUFFER_SIZE, size_t PAYLOAD_SIZE>
+void run(Pattern pattern, size_t samples)
+{
+    /** a quarter of the buffer per push batch, the timeout holds at most
+     * half of it, so that the buffers do not overflow **/
+    const size_t burst = std::max<size_t>(BUFFER_SIZE / 4, 1);
+    const base::Time timeout = base::Time::fromMicroseconds(
+            (pattern == BURSTY ? 2 * burst : std::min<size_t>(10, BUFFER_SIZE / 2)) * PERIOD);
+
+    const std::vector<Arrival> events = arrivals(pattern, STREAMS, pattern == BURSTY ? burst : 1, samples);
+    Payload<PAYLOAD_SIZE> sample;
+    std::memset(&sample, 0, sizeof(sample));
+
+    /** batches of pushes, then steps until no sample can be released **/
+    Benchmark<STREAMS, BUFFER_SIZE, PAYLOAD_SIZE> batched(timeout, false);
+    const size_t batch = STREAMS * burst;
+    int64_t push_time = 0, step_time = 0;
+    for (size_t i = 0; i < events.size(); i += batch)
+    {
+        size_t end = std::min(i + batch, events.size());
+        int64_t start = now();
+        for (size_t j = i; j < end; ++j)
+            batched.push(events[j], sample);
+        int64_t pushed = now();
+        while (batched.get().step())
+            ;
+        step_time += now() - pushed;
+        push_time += pushed - start;
+    }
+    size_t step_released = batched.getResults().released;
+
+    /** one push, then steps, as a processing loop does **/
+    Benchmark<STREAMS, BUFFER_SIZE, PAYLOAD_SIZE> interleaved(timeout, true);
+    interleaved.getResults().latencies.reserve(events.size());
+    int64_t start = now();
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        sample.pushed = now();
+        interleaved.push(events[i], sample);
+        while (interleaved.get().step())
+            ;
+    }
+    int64_t e2e_time = now() - start;
+
+    std::vector<int64_t> &latencies(interleaved.getResults().latencies);
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) -> int64_t
+    {
+        if (latencies.empty())
+            return 0;
+        return latencies[std::min(latencies.size() - 1, size_t(p * latencies.size()))];
+    };
+
+    std::cout << STREAMS << "," << BUFFER_SIZE << "," << PAYLOAD_SIZE << "," << patternName(pattern) << ","
+        << events.size() << "," << interleaved.getResults().released << "," << interleaved.dropped() << ","
+        << double(push_time) / events.size() << ","
+        << (step_released ? double(step_time) / step_released : 0) << ","
+        << double(e2e_time) / events.size() << ","
+        << percentile(0.5) << "," << percentile(0.99) << "," << (latencies.empty() ? 0 : latencies.back())
+        << std::endl;
+}
+
+template <size_t STREAMS, size_t BUFFER_SIZE, size_t PAYLOAD_SIZE>
+void runPatterns(size_t samples)
+{
+    run<STREAMS, BUFFER_SIZE, PAYLOAD_SIZE>(PERIODIC, samples);
+    run<STREAMS, BUFFER_SIZE, PAYLOAD_SIZE>(BURSTY, samples);
+    run<STREAMS, BUFFER_SIZE, PAYLOAD_SIZE>(STALLED, samples);
+}
+
+template <size_t STREAMS, size_t BUFFER_SIZE>
+void runPayloads(size_t samples)
+{
+    runPatterns<STREAMS, BUFFER_SIZE, 8>(samples);
+    runPatterns<STREAMS, BUFFER_SIZE, 256>(samples);
+    runPatterns<STREAMS, BUFFER_SIZE, 4096>(samples);
+}
+
+template <size_t STREAMS>
+void runBuffers(size_t samples)
+{
+    runPayloads<STREAMS, 16>(samples);
+    runPayloads<STREAMS, 256>(samples);
+}
+
+int main(int argc, char **argv)
+{
+    size_t samples = SAMPLES;
+    if (argc > 1)
+        samples = std::strtoul(argv[1], NULL, 10);
+
+    std::cout << "streams,buffer_size,payload,pattern,samples,released,dropped,"
+        "push_ns,step_ns,e2e_ns,latency_p50_ns,latency_p99_ns,latency_max_ns" << std::endl;
+
+    runBuffers<4>(samples);
+    runBuffers<16>(samples);
+    runBuffers<64>(samples);
+
+    return 0;
+}
@@ -464,3 +464,79 @@ BOOST_AUTO_TEST_CASE(test_perfect_circular_item_array_iterator)
     }
 }
 
+
+BOOST_AUTO_TEST_CASE(test_circular_array_move_and_emplace)
+{
+    typedef std::pair<base::Time,std::string> item;
+    std::cout<<"\n*** CIRCULAR ARRAY [TEST 11] ***\n";
+
+    stream_aligner::CircularArray<item, 2> buffer;
+
+    std::string payload(1000, 'a');
+    buffer.push_back(item(base::Time::fromSeconds(1.0), std::move(payload)));
+    item &last = buffer.emplace_back(base::Time::fromSeconds(2.0), std::string(1000, 'b'));
+
+    BOOST_CHECK(&last == &*buffer.rbegin());
+    BOOST_CHECK(buffer.full() == true);
+    BOOST_CHECK(buffer.front().second == std::string(1000, 'a'));
+    BOOST_CHECK(buffer.back().second == std::string(1000, 'b'));
+
+    /** emplace overwrites the front-most element as push_back does **/
+    buffer.emplace_back(base::Time::fromSeconds(3.0), "c");
+    BOOST_CHECK(buffer.size() == 2);
+    BOOST_CHECK(buffer.front().first == base::Time::fromSeconds(2.0));
+    BOOST_CHECK(buffer.back().second == "c");
+}
+
+BOOST_AUTO_TEST_CASE(test_circular_array_references_and_consume)
+{
+    typedef std::pair<base::Time,std::string> item;
+    std::cout<<"\n*** CIRCULAR ARRAY [TEST 12] ***\n";
+
+    stream_aligner::CircularArray<item, 3> buffer;
+
+    /** there is no element to give access to in an empty array **/
+    const stream_aligner::CircularArray<item, 3> &const_buffer(buffer);
+    BOOST_CHECK_THROW(buffer.front(), std::runtime_error);
+    BOOST_CHECK_THROW(buffer.back(), std::runtime_error);
+    BOOST_CHECK_THROW(const_buffer.front(), std::runtime_error);
+    BOOST_CHECK_THROW(const_buffer.back(), std::runtime_error);
+    BOOST_CHECK(buffer.consume_front([](item &) { BOOST_FAIL("called on empty array"); }) == false);
+
+    buffer.emplace_back(base::Time::fromSeconds(1.0), "a");
+    buffer.emplace_back(base::Time::fromSeconds(2.0), "b");
+
+    /** front and back give access to the elements in place **/
+    BOOST_CHECK(&buffer.front() == buffer.begin());
+    BOOST_CHECK(&buffer.back() == buffer.rbegin());
+    buffer.back().second += "b";
+
+    const item *consumed = NULL;
+    BOOST_CHECK(buffer.consume_front([&consumed](item &element) { consumed = &element; BOOST_CHECK(element.second == "a"); }));
+    BOOST_CHECK(consumed != NULL);
+
+    /** the consumed slot has been released **/
+    BOOST_CHECK(consumed->second.empty());
+    BOOST_CHECK(buffer.size() == 1);
+    BOOST_CHECK(buffer.front().second == "bb");
+
+    item last = buffer.pop_front();
+    BOOST_CHECK(last.second == "bb");
+    BOOST_CHECK(buffer.empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_circular_array_at)
+{
+    std::cout<<"\n*** CIRCULAR ARRAY [TEST 13] ***\n";
+
+    stream_aligner::CircularArray<base::Time, 3> buffer;
+    for (int i = 1; i <= 5; ++i)
+        buffer.push_back(base::Time::fromSeconds(i));
+
+    /** positions are counted from the front, across the wrap around **/
+    BOOST_CHECK(buffer.at(0) == base::Time::fromSeconds(3));
+    BOOST_CHECK(buffer.at(1) == base::Time::fromSeconds(4));
+    BOOST_CHECK(buffer.at(2) == base::Time::fromSeconds(5));
+    BOOST_CHECK(&buffer.at(0) == &buffer.front());
+    BOOST_CHECK(&buffer.at(2) == &buffer.back());
+}
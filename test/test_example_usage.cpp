@@ -3,12 +3,6 @@
 
 #include <iostream>
 
-/** Ceiling function **/
-#define CEILING(x,y) (((x) + (y) - 1) / (y))
-
-/** Windows size in seconds **/
-#define WINDOW_SIZE 5
-
 /** Number of streams or provided interfaces (config value) **/
 #define NUMBER_OF_STREAMS 3
 
@@ -21,11 +15,17 @@
 * this defines the highest larency **/
 #define TIMEOUT S1_PERIOD+0.01 //a bit bigger than the lowest period
 
-/** Buffer size as a computation of timeout and period scaled witha factor
+/** Periods and timeout in microseconds, to size the buffers at compile time **/
+constexpr int64_t S1_PERIOD_US = S1_PERIOD * 1000000;
+constexpr int64_t S2_PERIOD_US = S2_PERIOD * 1000000;
+constexpr int64_t S3_PERIOD_US = S3_PERIOD * 1000000;
+constexpr int64_t TIMEOUT_US = (TIMEOUT) * 1000000;
+
+/** Buffer size as a computation of timeout and period scaled with a factor
  * typical two in order to store two cycles of timeout**/
-#define BUFFER_SIZE_S1 CEILING(WINDOW_SIZE, S1_PERIOD)
-#define BUFFER_SIZE_S2 CEILING(WINDOW_SIZE, S2_PERIOD)
-#define BUFFER_SIZE_S3 CEILING(WINDOW_SIZE, S3_PERIOD)
+constexpr size_t BUFFER_SIZE_S1 = stream_aligner::bufferSize(S1_PERIOD_US, TIMEOUT_US);
+constexpr size_t BUFFER_SIZE_S2 = stream_aligner::bufferSize(S2_PERIOD_US, TIMEOUT_US);
+constexpr size_t BUFFER_SIZE_S3 = stream_aligner::bufferSize(S3_PERIOD_US, TIMEOUT_US);
 
 /** When samples have the same time, the priority defines which one to choose at
  * first **/
@@ -58,9 +58,9 @@ int main()
 
     /** The aligner has a NUMBER_OF_STREAMS fixed size **/
     stream_aligner::StreamAligner<NUMBER_OF_STREAMS> aligner;
-    const size_t N_S1 = static_cast<size_t>(BUFFER_SIZE_S1);
-    const size_t N_S2 = static_cast<size_t>(BUFFER_SIZE_S2);
-    const size_t N_S3 = static_cast<size_t>(BUFFER_SIZE_S3);
+    const size_t N_S1 = BUFFER_SIZE_S1;
+    const size_t N_S2 = BUFFER_SIZE_S2;
+    const size_t N_S3 = BUFFER_SIZE_S3;
 
     std::cout<<"TIMEOUT: "<< TIMEOUT<<"\n";
     std::cout<<"N_S1: "<< N_S1<<"\n";
@@ -76,6 +76,9 @@ int main()
     int s2 = aligner.registerStream<double, N_S2>(&double_callback, base::Time::fromSeconds(S2_PERIOD), HIGH_PRIORITY);
     int s3 = aligner.registerStream<int, N_S3>(&int_callback, base::Time::fromSeconds(S3_PERIOD), MEDIUM_PRIORITY);
 
+    /** Throws if a buffer cannot hold the samples received during the timeout **/
+    aligner.checkBufferSizes();
+
 
     /** Push samples in stream 1 **/
     aligner.push<std::string, N_S1>(s1, base::Time::fromSeconds(1.0), std::string("a"));
@@ -2,14 +2,22 @@
 #define BOOST_TEST_MODULE "test_streamaligner"
 #define BOOST_AUTO_TEST_MAIN
 
+#include <atomic>
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <numeric>
+#include <thread>
+#include <vector>
 
 #include <boost/bind.hpp>
 #include <boost/test/unit_test.hpp>
 #include <boost/test/execution_monitor.hpp>
 
 #include <stream_aligner/StreamAligner.hpp>
+#include <stream_aligner/AsyncStreamAligner.hpp>
+#include <stream_aligner/StaticStreamAligner.hpp>
+#include <stream_aligner/StreamReplayer.hpp>
 #include "PullStreamAligner.hpp"
 
 using namespace stream_aligner;
@@ -471,3 +479,1564 @@ BOOST_AUTO_TEST_CASE( pull_stream_test )
     other.copyState(aligner);
 }
 
+
+std::vector<std::string> played_samples;
+
+void record_callback( const base::Time &, const std::string& sample )
+{
+    played_samples.push_back(sample);
+}
+
+/**
+ * This testcase checks the order in which samples are replayed
+ * when many streams interleave, including priorities on equal
+ * timestamps.
+ * */
+BOOST_AUTO_TEST_CASE( many_streams_order_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 15] ***\n";
+    static const size_t NUMBER_OF_STREAMS = 32;
+    StreamAligner<NUMBER_OF_STREAMS> aligner;
+    aligner.setTimeout(base::Time::fromSeconds(2.0));
+
+    /** callback, period_time, priority **/
+    const size_t N = 8;
+    int s[NUMBER_OF_STREAMS];
+    for (size_t i = 0; i < NUMBER_OF_STREAMS; ++i)
+        s[i] = aligner.registerStream<std::string, N>(&record_callback, base::Time::fromSeconds(1.0), NUMBER_OF_STREAMS - i);
+
+    /** stream i has samples at i/10 + k **/
+    for (size_t k = 0; k < 4; ++k)
+    {
+        for (size_t i = 0; i < NUMBER_OF_STREAMS; ++i)
+        {
+            aligner.push<std::string, N>(s[i], base::Time::fromSeconds(k + (i % 4) * 0.1),
+                    std::to_string(k) + ":" + std::to_string(i));
+        }
+    }
+
+    played_samples.clear();
+    while(aligner.step());
+
+    BOOST_CHECK_EQUAL(played_samples.size(), 4 * NUMBER_OF_STREAMS);
+    for (size_t j = 0; j < played_samples.size(); ++j)
+    {
+        size_t k = j / NUMBER_OF_STREAMS;
+        size_t group = (j % NUMBER_OF_STREAMS) / (NUMBER_OF_STREAMS / 4);
+        size_t rank = (j % NUMBER_OF_STREAMS) % (NUMBER_OF_STREAMS / 4);
+
+        /** on equal timestamps, the lowest priority value is first **/
+        size_t i = group + 4 * (NUMBER_OF_STREAMS / 4 - 1 - rank);
+        BOOST_CHECK_EQUAL(played_samples[j], std::to_string(k) + ":" + std::to_string(i));
+    }
+
+    /** all streams expect a sample at 4s, so wait until the timeout **/
+    aligner.push<std::string, N>(s[0], base::Time::fromSeconds(5.0), std::string("late"));
+    BOOST_CHECK(!aligner.step());
+
+    /** timeout reached for the first one, but not for the second **/
+    aligner.push<std::string, N>(s[0], base::Time::fromSeconds(6.0), std::string("end"));
+    played_samples.clear();
+    while(aligner.step());
+    BOOST_CHECK_EQUAL(played_samples.size(), 1);
+    BOOST_CHECK_EQUAL(played_samples.back(), std::string("late"));
+}
+
+BOOST_AUTO_TEST_CASE( drain_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 16] ***\n";
+    StreamAligner<NUMBER_OF_STREAMS> aligner;
+    aligner.setTimeout(base::Time::fromSeconds(2.0));
+
+    /** callback, period_time, (optional) priority **/
+    const size_t N = 8;
+    int s1 = aligner.registerStream<std::string, N>(&record_callback, base::Time::fromSeconds(1.0));
+    int s2 = aligner.registerStream<std::string, N>(&record_callback, base::Time::fromSeconds(1.0), 1);
+
+    aligner.push<std::string, N>(s1, base::Time::fromSeconds(1.0), std::string("a"));
+    aligner.push<std::string, N>(s2, base::Time::fromSeconds(1.5), std::string("b"));
+    aligner.push<std::string, N>(s1, base::Time::fromSeconds(2.0), std::string("c"));
+    aligner.push<std::string, N>(s2, base::Time::fromSeconds(2.5), std::string("d"));
+    aligner.push<std::string, N>(s1, base::Time::fromSeconds(3.0), std::string("e"));
+
+    played_samples.clear();
+    BOOST_CHECK_EQUAL(aligner.stepN(2), 2);
+    BOOST_CHECK_EQUAL(played_samples.back(), std::string("b"));
+
+    BOOST_CHECK_EQUAL(aligner.stepUntil(base::Time::fromSeconds(2.0)), 1);
+    BOOST_CHECK_EQUAL(played_samples.back(), std::string("c"));
+
+    /** s2 is expected at 3.5 so e can be played, but not more **/
+    BOOST_CHECK_EQUAL(aligner.drain(), 2);
+    BOOST_CHECK_EQUAL(played_samples.back(), std::string("e"));
+    BOOST_CHECK_EQUAL(aligner.drain(), 0);
+
+    aligner.push<std::string, N>(s2, base::Time::fromSeconds(3.5), std::string("f"));
+    BOOST_CHECK_EQUAL(aligner.drain(), 1);
+    BOOST_CHECK_EQUAL(played_samples.size(), 6);
+    BOOST_CHECK_EQUAL(played_samples.back(), std::string("f"));
+}
+
+BOOST_AUTO_TEST_CASE( stream_handle_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 17] ***\n";
+    StreamAligner<NUMBER_OF_STREAMS> aligner;
+    aligner.setTimeout(base::Time::fromSeconds(2.0));
+
+    /** callback, period_time, (optional) priority **/
+    const size_t N = 4;
+    StreamHandle<std::string, N> h1 = aligner.registerStreamHandle<std::string, N>(&test_callback, base::Time::fromSeconds(2));
+    StreamHandle<std::string, N> h2 = aligner.registerStreamHandle<std::string, N>(&test_callback, base::Time::fromSeconds(2), 1);
+    BOOST_CHECK(h1.valid() && h2.valid());
+    BOOST_CHECK(h1.index != h2.index);
+
+    /** handles and indices can be mixed **/
+    aligner.push(h1, base::Time::fromSeconds(1.0), "a");
+    aligner.push<std::string, N>(h2.index, base::Time::fromSeconds(2.0), std::string("b"));
+    aligner.push(h1, base::Time::fromSeconds(3.0), std::string("c"));
+
+    std::pair<base::Time, std::string> sample;
+    BOOST_CHECK(aligner.getNextSample(h1, sample));
+    BOOST_CHECK(sample.second == "a");
+
+    last_sample = ""; aligner.step(); BOOST_CHECK(last_sample == "a");
+    last_sample = ""; aligner.step(); BOOST_CHECK(last_sample == "b");
+
+    /** late samples are dropped as with push(int, ...) **/
+    aligner.push(h2, base::Time::fromSeconds(1.5), std::string("x"));
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(h2).samples_dropped_late_arriving, 1);
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(h2).samples_received, 2);
+}
+
+/** payload which counts how often it gets copied **/
+struct counted_payload
+{
+    static int copies;
+    std::string value;
+
+    counted_payload() {}
+    explicit counted_payload(const std::string &value) : value(value) {}
+    counted_payload(const std::string &value, size_t repeat) : value(repeat, value[0]) {}
+    counted_payload(const counted_payload &other) : value(other.value) { copies++; }
+    counted_payload(counted_payload &&other) : value(std::move(other.value)) {}
+    counted_payload& operator=(const counted_payload &other) { value = other.value; copies++; return *this; }
+    counted_payload& operator=(counted_payload &&other) { value = std::move(other.value); return *this; }
+};
+int counted_payload::copies = 0;
+
+void counted_callback( const base::Time &, const counted_payload& sample )
+{
+    last_sample = sample.value;
+}
+
+BOOST_AUTO_TEST_CASE( move_and_emplace_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 18] ***\n";
+    StreamAligner<NUMBER_OF_STREAMS> aligner;
+    aligner.setTimeout(base::Time::fromSeconds(2.0));
+
+    const size_t N = 4;
+    int s1 = aligner.registerStream<counted_payload, N>(&counted_callback, base::Time::fromSeconds(0));
+    StreamHandle<counted_payload, N> h2 = aligner.registerStreamHandle<counted_payload, N>(&counted_callback, base::Time::fromSeconds(0));
+
+    counted_payload::copies = 0;
+    aligner.push<counted_payload, N>(s1, base::Time::fromSeconds(1.0), counted_payload("a"));
+    aligner.emplace<counted_payload, N>(s1, base::Time::fromSeconds(2.0), "bbb");
+    aligner.push(h2, base::Time::fromSeconds(1.5), counted_payload("c"));
+    aligner.emplace(h2, base::Time::fromSeconds(2.5), "d", 3);
+    BOOST_CHECK_EQUAL(counted_payload::copies, 0);
+
+    /** pushing a lvalue copies it exactly once **/
+    counted_payload e("e");
+    aligner.push(h2, base::Time::fromSeconds(3.0), e);
+    BOOST_CHECK_EQUAL(counted_payload::copies, 1);
+
+    last_sample = ""; aligner.step(); BOOST_CHECK(last_sample == "a");
+    last_sample = ""; aligner.step(); BOOST_CHECK(last_sample == "c");
+    last_sample = ""; aligner.step(); BOOST_CHECK(last_sample == "bbb");
+
+    /** s1 has a zero period, so the next samples wait for its timeout **/
+    aligner.disableStream(s1);
+    last_sample = ""; aligner.step(); BOOST_CHECK(last_sample == "ddd");
+    last_sample = ""; aligner.step(); BOOST_CHECK(last_sample == "e");
+}
+
+BOOST_AUTO_TEST_CASE( zero_copy_pop_and_peek_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 19] ***\n";
+    StreamAligner<NUMBER_OF_STREAMS> aligner;
+    aligner.setTimeout(base::Time::fromSeconds(2.0));
+
+    const size_t N = 4;
+    StreamHandle<counted_payload, N> h1 = aligner.registerStreamHandle<counted_payload, N>(&counted_callback, base::Time::fromSeconds(1));
+
+    base::Time ts;
+    BOOST_CHECK(aligner.peekNextSample(h1, ts) == NULL);
+
+    aligner.emplace(h1, base::Time::fromSeconds(1.0), "a");
+    aligner.emplace(h1, base::Time::fromSeconds(2.0), "b");
+
+    counted_payload::copies = 0;
+    const counted_payload *next = aligner.peekNextSample<counted_payload, N>(h1.index, ts);
+    BOOST_REQUIRE(next != NULL);
+    BOOST_CHECK(next->value == "a");
+    BOOST_CHECK(ts == base::Time::fromSeconds(1.0));
+
+    last_sample = ""; aligner.step(); BOOST_CHECK(last_sample == "a");
+    next = aligner.peekNextSample(h1, ts);
+    BOOST_REQUIRE(next != NULL);
+    BOOST_CHECK(next->value == "b");
+    BOOST_CHECK(ts == base::Time::fromSeconds(2.0));
+
+    last_sample = ""; aligner.step(); BOOST_CHECK(last_sample == "b");
+    BOOST_CHECK(aligner.peekNextSample(h1, ts) == NULL);
+
+    /** neither the peek nor the callbacks copied the samples **/
+    BOOST_CHECK_EQUAL(counted_payload::copies, 0);
+}
+
+/** functor callback **/
+struct counting_callback
+{
+    size_t *count;
+    std::string *last;
+
+    void operator()( const base::Time &, const std::string& sample )
+    {
+        (*count)++;
+        *last = sample;
+    }
+};
+
+BOOST_AUTO_TEST_CASE( callback_types_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 20] ***\n";
+    StreamAligner<NUMBER_OF_STREAMS> aligner;
+    aligner.setTimeout(base::Time::fromSeconds(2.0));
+
+    const size_t N = 4;
+    size_t count = 0;
+    std::string lambda_sample, functor_sample;
+    counting_callback functor = { &count, &functor_sample };
+
+    /** lambda with captures, functor, boost::function and no callback **/
+    int s1 = aligner.registerStream<std::string, N>([&count, &lambda_sample](const base::Time &, const std::string &sample)
+            { count++; lambda_sample = sample; }, base::Time::fromSeconds(0));
+    int s2 = aligner.registerStream<std::string, N>(functor, base::Time::fromSeconds(0));
+    int s3 = aligner.registerStream<std::string, N>(boost::function<void (const base::Time &, const std::string &)>(&test_callback), base::Time::fromSeconds(0));
+    int s4 = aligner.registerStream<std::string, N>(nullptr, base::Time::fromSeconds(0));
+    int s5 = aligner.registerStream<std::string, N>(boost::function<void (const base::Time &, const std::string &)>(), base::Time::fromSeconds(0));
+
+    aligner.push<std::string, N>(s1, base::Time::fromSeconds(1.0), std::string("a"));
+    aligner.push<std::string, N>(s2, base::Time::fromSeconds(1.0), std::string("b"));
+    aligner.push<std::string, N>(s3, base::Time::fromSeconds(1.0), std::string("c"));
+    aligner.push<std::string, N>(s4, base::Time::fromSeconds(1.0), std::string("d"));
+    aligner.push<std::string, N>(s5, base::Time::fromSeconds(1.0), std::string("e"));
+
+    last_sample = "";
+    BOOST_CHECK_EQUAL(aligner.drain(), 5);
+    BOOST_CHECK_EQUAL(count, 2);
+    BOOST_CHECK(lambda_sample == "a");
+    BOOST_CHECK(functor_sample == "b");
+    BOOST_CHECK(last_sample == "c");
+
+    /** samples without callbacks are still processed **/
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(s4).samples_processed, 1);
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(s5).samples_processed, 1);
+}
+
+BOOST_AUTO_TEST_CASE( concurrent_ingestion_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 21] ***\n";
+    static const size_t STREAMS = 4;
+    static const size_t SAMPLES = 5000;
+    StreamAligner<NUMBER_OF_STREAMS> aligner;
+    aligner.setTimeout(base::Time::fromSeconds(10.0));
+
+    /** callback, period_time: each stream has a sample every 4 ms.
+     * A producer may run far ahead of the others, the buffers hold
+     * every sample so that nothing is overwritten while waiting **/
+    const size_t N = SAMPLES;
+    const size_t Q = 256;
+    std::vector<base::Time> played;
+    std::array<ConcurrentStreamHandle<int, N, Q>, STREAMS> handles;
+    for (size_t i = 0; i < STREAMS; ++i)
+    {
+        handles[i] = aligner.registerConcurrentStream<int, N, Q>(
+                [&played](const base::Time &ts, const int &) { played.push_back(ts); },
+                base::Time::fromMilliseconds(4));
+    }
+
+    /** one producer per stream, the streams are interleaved in time. They
+     * give up once the consumer stops draining **/
+    std::atomic<bool> stopped(false);
+    std::vector<std::thread> producers;
+    for (size_t i = 0; i < STREAMS; ++i)
+    {
+        producers.push_back(std::thread([&aligner, &handles, &stopped, i]()
+        {
+            for (size_t k = 0; k < SAMPLES; ++k)
+            {
+                base::Time ts = base::Time::fromMicroseconds(1000 + 4000 * k + 1000 * i);
+                while (!aligner.pushConcurrent(handles[i], ts, static_cast<int>(k)))
+                {
+                    if (stopped.load())
+                        return;
+                    std::this_thread::yield();
+                }
+            }
+        }));
+    }
+
+    /** a regression fails the test instead of hanging it **/
+    base::Time deadline = base::Time::now() + base::Time::fromSeconds(30);
+    while (played.size() < STREAMS * (SAMPLES - 1) && base::Time::now() < deadline)
+        aligner.drain();
+    bool complete = played.size() >= STREAMS * (SAMPLES - 1);
+
+    stopped.store(true);
+    for (size_t i = 0; i < STREAMS; ++i)
+        producers[i].join();
+    BOOST_REQUIRE(complete);
+    aligner.drain();
+
+    /** everything is played in order, the last samples wait for the next ones **/
+    BOOST_CHECK(played.size() >= STREAMS * (SAMPLES - 1));
+    for (size_t j = 1; j < played.size(); ++j)
+        BOOST_REQUIRE(played[j - 1] < played[j]);
+
+    for (size_t i = 0; i < STREAMS; ++i)
+    {
+        const StreamStatus &status(aligner.getBufferStatus(handles[i]));
+        /** rejected pushes are retried, they are counted as received and dropped **/
+        BOOST_CHECK_EQUAL(status.samples_received, SAMPLES + status.samples_dropped_queue_full);
+        BOOST_CHECK_EQUAL(status.samples_dropped_late_arriving, 0);
+        BOOST_CHECK_EQUAL(status.samples_dropped_buffer_full, 0);
+        BOOST_CHECK_EQUAL(status.samples_processed + status.buffer_fill, SAMPLES);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( concurrent_queue_full_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 22] ***\n";
+    StreamAligner<NUMBER_OF_STREAMS> aligner;
+    aligner.setTimeout(base::Time::fromSeconds(2.0));
+
+    const size_t N = 8;
+    ConcurrentStreamHandle<std::string, N, 2> h1 = aligner.registerConcurrentStream<std::string, N, 2>(&test_callback, base::Time::fromSeconds(0));
+
+    BOOST_CHECK(aligner.pushConcurrent(h1, base::Time::fromSeconds(1.0), std::string("a")));
+    BOOST_CHECK(aligner.pushConcurrent(h1, base::Time::fromSeconds(2.0), "b"));
+    BOOST_CHECK(!aligner.pushConcurrent(h1, base::Time::fromSeconds(3.0), "c"));
+
+    /** the concurrent stream is a normal stream for the aligner thread **/
+    aligner.push(h1, base::Time::fromSeconds(0.5), std::string("z"));
+
+    last_sample = ""; aligner.step(); BOOST_CHECK(last_sample == "z");
+    last_sample = ""; aligner.step(); BOOST_CHECK(last_sample == "a");
+    last_sample = ""; aligner.step(); BOOST_CHECK(last_sample == "b");
+
+    const StreamStatus &status(aligner.getBufferStatus(h1));
+    BOOST_CHECK_EQUAL(status.samples_received, 4);
+    BOOST_CHECK_EQUAL(status.samples_dropped_queue_full, 1);
+    BOOST_CHECK_EQUAL(status.samples_processed, 3);
+}
+
+BOOST_AUTO_TEST_CASE( async_aligner_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 23] ***\n";
+    AsyncStreamAligner<NUMBER_OF_STREAMS> aligner(base::Time::fromMilliseconds(100));
+
+    /** the callbacks run in the worker thread **/
+    std::mutex played_mutex;
+    std::vector<base::Time> played;
+    std::vector<base::Time> released;
+    auto callback = [&](const base::Time &ts, const int &)
+    {
+        std::lock_guard<std::mutex> lock(played_mutex);
+        played.push_back(ts);
+        released.push_back(base::Time::now());
+    };
+    auto wait_played = [&](size_t count)
+    {
+        base::Time end = base::Time::now() + base::Time::fromSeconds(5);
+        while(base::Time::now() < end)
+        {
+            {
+                std::lock_guard<std::mutex> lock(played_mutex);
+                if(played.size() >= count)
+                    return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    };
+
+    const size_t N = 4;
+    int s1 = aligner.registerStream<int, N>(callback, base::Time::fromMilliseconds(10));
+    StreamHandle<int, N> s2 = aligner.registerStreamHandle<int, N>(callback, base::Time::fromMilliseconds(10));
+    aligner.start();
+    BOOST_CHECK(aligner.isRunning());
+
+    /** a push wakes the worker up **/
+    base::Time t0 = base::Time::now();
+    aligner.push<int, N>(s1, t0, 1);
+    aligner.push(s2, t0, 2);
+    BOOST_REQUIRE(wait_played(2));
+
+    /** s2 is expected at t0 + 10ms, the sample of s1 waits for the timeout
+     * which is reached at t0 + 100ms, 80ms of wall time after the data time
+     * got to t0 + 20ms, without any other push **/
+    base::Time pushed = base::Time::now();
+    aligner.push<int, N>(s1, t0 + base::Time::fromMilliseconds(20), 3);
+    BOOST_REQUIRE(wait_played(3));
+    {
+        std::lock_guard<std::mutex> lock(played_mutex);
+        BOOST_CHECK(played[2] == t0 + base::Time::fromMilliseconds(20));
+        BOOST_CHECK(!(released[2] < pushed + base::Time::fromMilliseconds(80)));
+    }
+
+    aligner.stop();
+    BOOST_CHECK(!aligner.isRunning());
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(s1).samples_processed, 2);
+    BOOST_CHECK(aligner.getCurrentTime() == t0 + base::Time::fromMilliseconds(20));
+}
+
+BOOST_AUTO_TEST_CASE( next_release_time_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 24] ***\n";
+    StreamAligner<NUMBER_OF_STREAMS> aligner;
+    aligner.setTimeout(base::Time::fromSeconds(2.0));
+
+    const size_t N = 4;
+    int s1 = aligner.registerStream<std::string, N>(&test_callback, base::Time::fromSeconds(1));
+    int s2 = aligner.registerStream<std::string, N>(&test_callback, base::Time::fromSeconds(1));
+
+    /** nothing to release **/
+    BOOST_CHECK(!aligner.isReady());
+    BOOST_CHECK(aligner.nextReleaseTime() == base::Time::max());
+
+    aligner.push<std::string, N>(s1, base::Time::fromSeconds(1.0), std::string("a"));
+    aligner.push<std::string, N>(s2, base::Time::fromSeconds(1.0), std::string("b"));
+    BOOST_CHECK(aligner.isReady());
+    BOOST_CHECK(aligner.nextReleaseTime() == base::Time::fromSeconds(1.0));
+    BOOST_CHECK_EQUAL(aligner.drain(), 2);
+
+    /** s2 is expected at 2s, the sample of s1 waits until the timeout is
+     * reached at 1s + 2s **/
+    aligner.push<std::string, N>(s1, base::Time::fromSeconds(2.5), std::string("c"));
+    BOOST_CHECK(!aligner.isReady());
+    BOOST_CHECK(aligner.nextReleaseTime() == base::Time::fromSeconds(3.0));
+
+    /** no side effects **/
+    BOOST_CHECK(aligner.nextReleaseTime() == base::Time::fromSeconds(3.0));
+    BOOST_CHECK(aligner.getLatestTime() == base::Time::fromSeconds(2.5));
+
+    aligner.advanceTime(base::Time::fromSeconds(2.9));
+    BOOST_CHECK(!aligner.isReady());
+    BOOST_CHECK(!aligner.step());
+
+    aligner.advanceTime(base::Time::fromSeconds(3.0));
+    BOOST_CHECK(aligner.isReady());
+    BOOST_CHECK(aligner.nextReleaseTime() == base::Time::fromSeconds(3.0));
+    last_sample = "";
+    BOOST_CHECK(aligner.step());
+    BOOST_CHECK(last_sample == "c");
+    BOOST_CHECK(aligner.nextReleaseTime() == base::Time::max());
+}
+
+BOOST_AUTO_TEST_CASE( dynamic_stream_aligner_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 25] ***\n";
+    DynamicStreamAligner aligner;
+
+    /** no waiting for empty streams, the oldest sample is always released **/
+    aligner.setTimeout(base::Time());
+    BOOST_CHECK_EQUAL(aligner.getStreamSize(), 0);
+
+    /** more streams than a fixed size aligner would take **/
+    const size_t STREAMS = 3 * NUMBER_OF_STREAMS;
+    const size_t N = 4;
+    std::vector<int> played;
+    std::vector<StreamHandle<int, N> > handles;
+    for (size_t i = 0; i < STREAMS; ++i)
+    {
+        handles.push_back(aligner.registerStreamHandle<int, N>(
+                [&played](const base::Time &, const int &value) { played.push_back(value); },
+                base::Time::fromSeconds(0)));
+        BOOST_CHECK_EQUAL(handles[i].index, i);
+    }
+    BOOST_CHECK_EQUAL(aligner.getStreamSize(), STREAMS);
+
+    /** streams pushed in reverse order are released in time order **/
+    for (size_t i = 0; i < STREAMS; ++i)
+        aligner.push(handles[STREAMS - 1 - i], base::Time::fromSeconds(static_cast<double>(STREAMS - i)), static_cast<int>(STREAMS - 1 - i));
+    BOOST_CHECK_EQUAL(aligner.drain(), STREAMS);
+    for (size_t i = 0; i < STREAMS; ++i)
+        BOOST_CHECK_EQUAL(played[i], i);
+
+    /** freed slots are reused, lowest index first, without growing **/
+    aligner.unregisterStream(7);
+    aligner.unregisterStream(3);
+    BOOST_CHECK_EQUAL((aligner.registerStream<int, N>(nullptr, base::Time::fromSeconds(0))), 3);
+    BOOST_CHECK_EQUAL((aligner.registerStream<int, N>(nullptr, base::Time::fromSeconds(0))), 7);
+    BOOST_CHECK_EQUAL((aligner.registerStream<int, N>(nullptr, base::Time::fromSeconds(0))), STREAMS);
+    BOOST_CHECK_EQUAL(aligner.getStreamSize(), STREAMS + 1);
+    BOOST_CHECK_EQUAL(aligner.getStatus().streams.size(), STREAMS + 1);
+
+    /** the ordering still holds after the storage grew **/
+    played.clear();
+    aligner.push(handles[5], base::Time::fromSeconds(STREAMS + 2.0), 5);
+    aligner.push(handles[1], base::Time::fromSeconds(STREAMS + 1.0), 1);
+    BOOST_CHECK_EQUAL(aligner.drain(), 2);
+    BOOST_REQUIRE_EQUAL(played.size(), 2);
+    BOOST_CHECK_EQUAL(played[0], 1);
+    BOOST_CHECK_EQUAL(played[1], 5);
+}
+
+BOOST_AUTO_TEST_CASE( growable_buffer_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 26] ***\n";
+    StreamAligner<NUMBER_OF_STREAMS> aligner;
+    aligner.setTimeout(base::Time::fromSeconds(100.0));
+
+    /** chunks of three samples: pair<Time,int> after the chunk header **/
+    aligner.setBufferPool(64, 2);
+
+    const size_t N = 4;
+    std::vector<int> played;
+    StreamHandle<int, N> s1 = aligner.registerStreamHandle<int, N>(
+            [&played](const base::Time &, const int &value) { played.push_back(value); },
+            base::Time::fromSeconds(0));
+    int s2 = aligner.registerStream<int, N>(nullptr, base::Time::fromSeconds(1));
+    aligner.enableBufferGrowth(s1);
+
+    /** s2 is expected at 1s, s1 falls behind **/
+    for (int i = 0; i < 10; ++i)
+        aligner.push(s1, base::Time::fromSeconds(2.0 + i), i);
+    BOOST_CHECK(!aligner.step());
+
+    StreamStatus status = aligner.getBufferStatus(s1);
+    BOOST_CHECK_EQUAL(status.buffer_fill, 10);
+    BOOST_CHECK_EQUAL(status.buffer_size, 10);
+    BOOST_CHECK_EQUAL(status.buffer_growths, 2);
+    BOOST_CHECK_EQUAL(status.samples_dropped_buffer_full, 0);
+    BOOST_CHECK_EQUAL(aligner.getBufferPool().chunksUsed(), 2);
+
+    /** the pool is exhausted, the new sample is dropped **/
+    aligner.push(s1, base::Time::fromSeconds(12.0), 10);
+    status = aligner.getBufferStatus(s1);
+    BOOST_CHECK_EQUAL(status.buffer_fill, 10);
+    BOOST_CHECK_EQUAL(status.samples_dropped_buffer_full, 1);
+
+    /** the samples are played in order and the buffer shrinks back **/
+    aligner.disableStream(s2);
+    BOOST_CHECK_EQUAL(aligner.drain(), 10);
+    BOOST_REQUIRE_EQUAL(played.size(), 10);
+    for (int i = 0; i < 10; ++i)
+        BOOST_CHECK_EQUAL(played[i], i);
+
+    status = aligner.getBufferStatus(s1);
+    BOOST_CHECK_EQUAL(status.buffer_size, N);
+    BOOST_CHECK_EQUAL(status.buffer_shrinks, 2);
+    BOOST_CHECK_EQUAL(aligner.getBufferPool().chunksUsed(), 0);
+    BOOST_CHECK_EQUAL(aligner.getBufferPool().chunksAllocated(), 2);
+
+    /** without growth, the oldest samples are overwritten again **/
+    aligner.disableBufferGrowth(s1);
+    for (int i = 0; i < 6; ++i)
+        aligner.push(s1, base::Time::fromSeconds(20.0 + i), i);
+    status = aligner.getBufferStatus(s1);
+    BOOST_CHECK_EQUAL(status.buffer_fill, N);
+    BOOST_CHECK_EQUAL(status.samples_dropped_buffer_full, 3);
+}
+
+BOOST_AUTO_TEST_CASE( reorder_window_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 27] ***\n";
+    StreamAligner<NUMBER_OF_STREAMS> aligner;
+    aligner.setTimeout(base::Time::fromSeconds(2.0));
+
+    const size_t N = 4;
+    std::vector<base::Time> played;
+    auto callback = [&played](const base::Time &ts, const int &) { played.push_back(ts); };
+    StreamHandle<int, N> s1 = aligner.registerStreamHandle<int, N>(callback, base::Time::fromSeconds(0));
+    aligner.setReorderWindow(s1, base::Time::fromMilliseconds(500));
+
+    aligner.push(s1, base::Time::fromSeconds(1.0), 0);
+    aligner.push(s1, base::Time::fromSeconds(1.4), 0);
+    aligner.push(s1, base::Time::fromSeconds(1.2), 0);
+    /** out of the window **/
+    aligner.push(s1, base::Time::fromSeconds(0.8), 0);
+    aligner.push(s1, base::Time::fromSeconds(1.3), 0);
+
+    StreamStatus status = aligner.getBufferStatus(s1);
+    BOOST_CHECK_EQUAL(status.samples_reordered, 2);
+    BOOST_CHECK_EQUAL(status.samples_backward_in_time, 1);
+    BOOST_CHECK(status.latest_data_time == base::Time::fromSeconds(1.4));
+
+    /** dropped because the buffer is full: not counted as reordered **/
+    aligner.setOverflowPolicy(s1, DROP_NEWEST);
+    aligner.push(s1, base::Time::fromSeconds(1.1), 0);
+    status = aligner.getBufferStatus(s1);
+    BOOST_CHECK_EQUAL(status.samples_reordered, 2);
+    BOOST_CHECK_EQUAL(status.samples_dropped_buffer_full, 1);
+    aligner.setOverflowPolicy(s1, OVERWRITE_OLDEST);
+
+    BOOST_CHECK_EQUAL(aligner.drain(), 4);
+    BOOST_REQUIRE_EQUAL(played.size(), 4);
+    BOOST_CHECK(played[0] == base::Time::fromSeconds(1.0));
+    BOOST_CHECK(played[1] == base::Time::fromSeconds(1.2));
+    BOOST_CHECK(played[2] == base::Time::fromSeconds(1.3));
+    BOOST_CHECK(played[3] == base::Time::fromSeconds(1.4));
+
+    /** older than the last played sample: dropped as late arriving **/
+    aligner.push(s1, base::Time::fromSeconds(1.35), 0);
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(s1).samples_dropped_late_arriving, 1);
+
+    /** reordering across a grown buffer **/
+    played.clear();
+    aligner.setBufferPool(64, 4);
+    aligner.enableBufferGrowth(s1);
+    const double times[] = { 2.0, 2.1, 2.2, 2.3, 2.5, 2.6, 2.7, 2.4, 2.25, 2.8 };
+    for (size_t i = 0; i < sizeof(times) / sizeof(times[0]); ++i)
+        aligner.push(s1, base::Time::fromSeconds(times[i]), 0);
+    BOOST_CHECK(aligner.getBufferStatus(s1).buffer_growths > 0);
+
+    BOOST_CHECK_EQUAL(aligner.drain(), 10);
+    BOOST_REQUIRE_EQUAL(played.size(), 10);
+    for (size_t i = 1; i < played.size(); ++i)
+        BOOST_CHECK(played[i - 1] < played[i]);
+
+    /** the statistics start over **/
+    aligner.clear();
+    status = aligner.getBufferStatus(s1);
+    BOOST_CHECK_EQUAL(status.samples_reordered, 0);
+    BOOST_CHECK_EQUAL(status.samples_backward_in_time, 0);
+    BOOST_CHECK_EQUAL(status.buffer_growths, 0);
+    BOOST_CHECK_EQUAL(status.buffer_shrinks, 0);
+}
+
+BOOST_AUTO_TEST_CASE( synchronizer_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 28] ***\n";
+    StreamAligner<NUMBER_OF_STREAMS> aligner;
+
+    /** the oldest sample is always released **/
+    aligner.setTimeout(base::Time());
+
+    const size_t N = 16;
+    StreamHandle<int, N> scan = aligner.registerStreamHandle<int, N>(nullptr, base::Time::fromSeconds(0));
+    StreamHandle<std::string, N> image = aligner.registerStreamHandle<std::string, N>(&test_callback, base::Time::fromSeconds(0));
+    StreamHandle<double, N> imu = aligner.registerStreamHandle<double, N>(nullptr, base::Time::fromSeconds(0));
+
+    typedef Synchronizer<8, int, std::string, double> sync_t;
+    std::vector<sync_t::times_t> tuples;
+    std::vector<std::string> images;
+    sync_t *sync = aligner.registerSynchronizer<8>(
+            [&tuples, &images](const sync_t::times_t &ts, const int &, const std::string &img, const double &)
+            { tuples.push_back(ts); images.push_back(img); },
+            base::Time::fromMilliseconds(50), scan, image, imu);
+
+    const double scan_times[] = { 1.00, 2.00, 3.00 };
+    const double image_times[] = { 1.02, 2.50, 3.01 };
+    const double imu_times[] = { 0.95, 0.99, 1.01, 1.05, 1.95, 2.02, 2.98, 3.02, 3.5 };
+    for (size_t i = 0; i < 3; ++i)
+    {
+        aligner.push(scan, base::Time::fromSeconds(scan_times[i]), static_cast<int>(i));
+        aligner.push(image, base::Time::fromSeconds(image_times[i]), std::string(1, 'a' + i));
+    }
+    for (size_t i = 0; i < 9; ++i)
+        aligner.push(imu, base::Time::fromSeconds(imu_times[i]), imu_times[i]);
+
+    last_sample = "";
+    BOOST_CHECK_EQUAL(aligner.drain(), 15);
+
+    /** the stream callbacks are replaced by the synchronizer **/
+    BOOST_CHECK(last_sample.empty());
+
+    /** each tuple has the minimum spread: 0.99 and 2.98 are skipped for
+     * the imu samples closer to the others **/
+    BOOST_REQUIRE_EQUAL(tuples.size(), 2);
+    BOOST_CHECK(tuples[0][0] == base::Time::fromSeconds(1.00));
+    BOOST_CHECK(tuples[0][1] == base::Time::fromSeconds(1.02));
+    BOOST_CHECK(tuples[0][2] == base::Time::fromSeconds(1.01));
+    BOOST_CHECK(images[0] == "a");
+    BOOST_CHECK(tuples[1][0] == base::Time::fromSeconds(3.00));
+    BOOST_CHECK(tuples[1][1] == base::Time::fromSeconds(3.01));
+    BOOST_CHECK(tuples[1][2] == base::Time::fromSeconds(3.02));
+    BOOST_CHECK(images[1] == "c");
+
+    BOOST_CHECK_EQUAL(sync->getTuplesMatched(), 2);
+    BOOST_CHECK_EQUAL(sync->getSamplesUnmatched(), 8);
+    BOOST_CHECK_EQUAL(sync->getSamplesWaiting(2), 1);
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(image).samples_processed, 3);
+
+    aligner.clear();
+    BOOST_CHECK_EQUAL(sync->getSamplesWaiting(2), 0);
+
+    /** the samples are moved from the streams to the synchronizer, not
+     * copied **/
+    StreamAligner<NUMBER_OF_STREAMS> moving;
+    moving.setTimeout(base::Time());
+    StreamHandle<counted_payload, N> left = moving.registerStreamHandle<counted_payload, N>(nullptr, base::Time::fromSeconds(0));
+    StreamHandle<counted_payload, N> right = moving.registerStreamHandle<counted_payload, N>(nullptr, base::Time::fromSeconds(0));
+    typedef Synchronizer<8, counted_payload, counted_payload> pair_sync_t;
+    std::vector<std::string> pairs;
+    moving.registerSynchronizer<8>(
+            [&pairs](const pair_sync_t::times_t &, const counted_payload &a, const counted_payload &b)
+            { pairs.push_back(a.value + b.value); },
+            base::Time::fromMilliseconds(50), left, right);
+
+    counted_payload::copies = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        moving.emplace(left, base::Time::fromSeconds(1.0 + i), std::string(1, 'a' + i));
+        moving.emplace(right, base::Time::fromSeconds(1.01 + i), std::string(1, 'x' + i));
+    }
+    BOOST_CHECK_EQUAL(moving.drain(), 6);
+    /** the last pair waits for a sample which could match better **/
+    BOOST_REQUIRE_EQUAL(pairs.size(), 2);
+    BOOST_CHECK_EQUAL(pairs[0], "ax");
+    BOOST_CHECK_EQUAL(pairs[1], "by");
+    BOOST_CHECK_EQUAL(counted_payload::copies, 0);
+}
+
+BOOST_AUTO_TEST_CASE( decimation_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 29] ***\n";
+    StreamAligner<NUMBER_OF_STREAMS> aligner;
+    aligner.setTimeout(base::Time());
+
+    const size_t N = 16;
+    std::vector<int> played1, played2;
+    int s1 = aligner.registerStream<int, N>([&played1](const base::Time &, const int &value) { played1.push_back(value); }, base::Time::fromMilliseconds(10));
+    int s2 = aligner.registerStream<int, N>([&played2](const base::Time &, const int &value) { played2.push_back(value); }, base::Time::fromMilliseconds(10));
+
+    /** 1 kHz streams, reduced to 100 Hz **/
+    aligner.setDecimation(s1, 10);
+    aligner.setRateLimit(s2, base::Time::fromMilliseconds(10));
+    for (int i = 0; i < 100; ++i)
+    {
+        aligner.push<int, N>(s1, base::Time::fromMilliseconds(1000 + i), i);
+        aligner.push<int, N>(s2, base::Time::fromMilliseconds(1000 + i), i);
+    }
+
+    const StreamStatus status1 = aligner.getBufferStatus(s1);
+    const StreamStatus status2 = aligner.getBufferStatus(s2);
+    BOOST_CHECK_EQUAL(status1.buffer_fill, 10);
+    BOOST_CHECK_EQUAL(status1.samples_dropped_decimation, 90);
+    BOOST_CHECK_EQUAL(status2.buffer_fill, 10);
+    BOOST_CHECK_EQUAL(status2.samples_dropped_decimation, 90);
+    BOOST_CHECK_EQUAL(status1.samples_received, 100);
+    BOOST_CHECK_EQUAL(status1.samples_dropped_buffer_full, 0);
+
+    BOOST_CHECK_EQUAL(aligner.drain(), 20);
+    BOOST_REQUIRE_EQUAL(played1.size(), 10);
+    BOOST_REQUIRE_EQUAL(played2.size(), 10);
+    for (int i = 0; i < 10; ++i)
+    {
+        BOOST_CHECK_EQUAL(played1[i], 10 * i);
+        BOOST_CHECK_EQUAL(played2[i], 10 * i);
+    }
+
+    /** disabled again, every sample is kept **/
+    aligner.setDecimation(s1, 1);
+    aligner.push<int, N>(s1, base::Time::fromMilliseconds(2000), 0);
+    aligner.push<int, N>(s1, base::Time::fromMilliseconds(2001), 1);
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(s1).buffer_fill, 2);
+}
+
+BOOST_AUTO_TEST_CASE( overflow_policy_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 30] ***\n";
+    StreamAligner<NUMBER_OF_STREAMS> aligner;
+    aligner.setTimeout(base::Time());
+
+    const size_t N = 4;
+    std::vector<int> played;
+    auto callback = [&played](const base::Time &, const int &value) { played.push_back(value); };
+    int s1 = aligner.registerStream<int, N>(callback, base::Time::fromMilliseconds(10));
+    int s2 = aligner.registerStream<int, N>(callback, base::Time::fromMilliseconds(10));
+    int s3 = aligner.registerStream<int, N>(callback, base::Time::fromMilliseconds(10));
+    aligner.setOverflowPolicy(s1, DROP_NEWEST);
+    aligner.setOverflowPolicy(s2, KEEP_LATEST);
+
+    for (int i = 0; i < 6; ++i)
+        aligner.push<int, N>(s1, base::Time::fromMilliseconds(1000 + i), i);
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(s1).samples_dropped_buffer_full, 2);
+    aligner.drain();
+    BOOST_REQUIRE_EQUAL(played.size(), 4);
+    BOOST_CHECK_EQUAL(played.front(), 0);
+    BOOST_CHECK_EQUAL(played.back(), 3);
+
+    played.clear();
+    for (int i = 0; i < 6; ++i)
+        aligner.push<int, N>(s2, base::Time::fromMilliseconds(2000 + i), i);
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(s2).samples_dropped_buffer_full, 4);
+    aligner.drain();
+    BOOST_REQUIRE_EQUAL(played.size(), 2);
+    BOOST_CHECK_EQUAL(played[0], 4);
+    BOOST_CHECK_EQUAL(played[1], 5);
+
+    /** default: the oldest samples are overwritten **/
+    played.clear();
+    for (int i = 0; i < 6; ++i)
+        aligner.push<int, N>(s3, base::Time::fromMilliseconds(3000 + i), i);
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(s3).samples_dropped_buffer_full, 2);
+    aligner.drain();
+    BOOST_REQUIRE_EQUAL(played.size(), 4);
+    BOOST_CHECK_EQUAL(played.front(), 2);
+    BOOST_CHECK_EQUAL(played.back(), 5);
+
+    /** samples wait in the queue of a full stream instead of being dropped **/
+    StreamAligner<NUMBER_OF_STREAMS> blocking;
+    blocking.setTimeout(base::Time());
+    played.clear();
+    ConcurrentStreamHandle<int, 2, 2> h = blocking.registerConcurrentStream<int, 2, 2>(callback, base::Time::fromMilliseconds(10));
+    blocking.setOverflowPolicy(h, BLOCK, base::Time::fromMilliseconds(1));
+
+    blocking.push(h, base::Time::fromMilliseconds(100), 0);
+    blocking.push(h, base::Time::fromMilliseconds(200), 1);
+    BOOST_CHECK(blocking.pushConcurrent(h, base::Time::fromMilliseconds(300), 2));
+    BOOST_CHECK(blocking.pushConcurrent(h, base::Time::fromMilliseconds(400), 3));
+    /** no one makes room, the producer gives up after the timeout **/
+    BOOST_CHECK(!blocking.pushConcurrent(h, base::Time::fromMilliseconds(500), 4));
+
+    /** a blocked producer is woken up as soon as the aligner makes room **/
+    blocking.setOverflowPolicy(h, BLOCK, base::Time::fromSeconds(10));
+    std::atomic<bool> pushed(false), done(false);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::thread producer([&blocking, &h, &pushed, &done]()
+    {
+        pushed = blocking.pushConcurrent(h, base::Time::fromMilliseconds(600), 5);
+        done = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    while (!done)
+    {
+        blocking.step();
+        std::this_thread::yield();
+    }
+    producer.join();
+    BOOST_CHECK(pushed);
+    BOOST_CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+
+    while (blocking.step())
+        ;
+    BOOST_REQUIRE_EQUAL(played.size(), 5);
+    for (int i = 0; i < 4; ++i)
+        BOOST_CHECK_EQUAL(played[i], i);
+    BOOST_CHECK_EQUAL(played[4], 5);
+
+    const StreamStatus status = blocking.getBufferStatus(h);
+    BOOST_CHECK_EQUAL(status.samples_received, 6);
+    BOOST_CHECK_EQUAL(status.samples_dropped_buffer_full, 0);
+    BOOST_CHECK_EQUAL(status.samples_dropped_queue_full, 1);
+    BOOST_CHECK_EQUAL(status.samples_blocked, 2);
+    BOOST_CHECK_EQUAL(status.samples_processed, 5);
+}
+
+BOOST_AUTO_TEST_CASE( spill_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 31] ***\n";
+    StreamAligner<NUMBER_OF_STREAMS> aligner;
+    aligner.setTimeout(base::Time());
+
+    const size_t N = 4;
+    std::vector<int> played;
+    std::vector<std::string> played_strings;
+    int s1 = aligner.registerStream<int, N>([&played](const base::Time &, const int &value) { played.push_back(value); }, base::Time::fromMilliseconds(10));
+    int s2 = aligner.registerStream<std::string, N>([&played_strings](const base::Time &, const std::string &value) { played_strings.push_back(value); }, base::Time::fromMilliseconds(10));
+    int s3 = aligner.registerStream<std::vector<int>, N>([](const base::Time &, const std::vector<int> &) {}, base::Time::fromMilliseconds(10));
+
+    aligner.enableSpill(s1, ".", 4096);
+    aligner.enableSpill(s2, ".");
+    BOOST_CHECK_THROW(aligner.enableSpill(s3, "."), std::runtime_error);
+
+    /** the consumer stalls, nothing is lost **/
+    const int SAMPLES = 100;
+    for (int i = 0; i < SAMPLES; ++i)
+    {
+        aligner.push<int, N>(s1, base::Time::fromMilliseconds(1000 + 2 * i), i);
+        aligner.push<std::string, N>(s2, base::Time::fromMilliseconds(1001 + 2 * i), std::string(i, 'x'));
+    }
+    /** within the reorder window, but too late to be put back at its place **/
+    aligner.setReorderWindow(s1, base::Time::fromSeconds(1));
+    aligner.push<int, N>(s1, base::Time::fromMilliseconds(1100), -1);
+
+    StreamStatus status = aligner.getBufferStatus(s1);
+    BOOST_CHECK_EQUAL(status.buffer_fill, SAMPLES);
+    BOOST_CHECK_EQUAL(status.spill_fill, SAMPLES - N);
+    BOOST_CHECK_EQUAL(status.samples_spilled, SAMPLES - N);
+    BOOST_CHECK_EQUAL(status.samples_dropped_buffer_full, 1);
+    BOOST_CHECK_THROW(aligner.disableSpill(s1), std::runtime_error);
+
+    BOOST_CHECK_EQUAL(aligner.drain(), 2 * SAMPLES);
+    BOOST_REQUIRE_EQUAL(played.size(), SAMPLES);
+    BOOST_REQUIRE_EQUAL(played_strings.size(), SAMPLES);
+    for (int i = 0; i < SAMPLES; ++i)
+    {
+        BOOST_CHECK_EQUAL(played[i], i);
+        BOOST_CHECK_EQUAL(played_strings[i], std::string(i, 'x'));
+    }
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(s1).spill_fill, 0);
+
+    /** the file is full: the new samples are dropped **/
+    for (int i = 0; i < 1000; ++i)
+        aligner.push<int, N>(s1, base::Time::fromMilliseconds(2000 + i), i);
+    status = aligner.getBufferStatus(s1);
+    BOOST_CHECK(status.spill_fill < 1000 - N);
+    BOOST_CHECK_EQUAL(status.buffer_fill + status.samples_dropped_buffer_full, 1000 + 1);
+
+    played.clear();
+    aligner.drain();
+    BOOST_REQUIRE_EQUAL(played.size(), status.buffer_fill);
+    for (size_t i = 0; i < played.size(); ++i)
+        BOOST_CHECK_EQUAL(played[i], i);
+    aligner.disableSpill(s1);
+
+    aligner.clear();
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(s1).samples_spilled, 0);
+}
+
+BOOST_AUTO_TEST_CASE( record_replay_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 32] ***\n";
+    const size_t N = 8;
+    const char *LOG = "stream_aligner_record_test.log";
+
+    /** what the aligner gives to the callbacks **/
+    typedef std::vector< std::pair<base::Time, std::string> > output_t;
+    auto setup = [](StreamAligner<NUMBER_OF_STREAMS> &aligner, output_t &output)
+    {
+        aligner.setTimeout(base::Time::fromMilliseconds(50));
+        aligner.registerStream<int, N>([&output](const base::Time &ts, const int &value) { output.push_back(std::make_pair(ts, std::to_string(value))); }, base::Time::fromMilliseconds(10));
+        aligner.registerStream<std::string, N>([&output](const base::Time &ts, const std::string &value) { output.push_back(std::make_pair(ts, value)); }, base::Time::fromMilliseconds(20));
+    };
+
+    output_t recorded;
+    {
+        StreamAligner<NUMBER_OF_STREAMS> aligner;
+        setup(aligner, recorded);
+        StreamRecorder recorder(LOG);
+        aligner.setRecorder(&recorder);
+
+        for (int i = 0; i < 50; ++i)
+        {
+            aligner.push<int, N>(0, base::Time::fromMilliseconds(1000 + 10 * i), i);
+            if (i % 2 == 0 && i < 30)
+                aligner.emplace<std::string, N>(1, base::Time::fromMilliseconds(1003 + 10 * i), i, 's');
+            if (i % 3 == 0)
+                aligner.step();
+            if (i % 7 == 0)
+                aligner.stepN(2);
+            if (i == 40)
+                aligner.disableStream(1);
+        }
+        aligner.stepUntil(base::Time::fromMilliseconds(1450));
+        aligner.advanceTime(base::Time::fromMilliseconds(2000));
+        aligner.drain();
+        BOOST_CHECK(recorder.getEvents() > 80);
+    }
+    BOOST_REQUIRE(recorded.size() > 30);
+
+    output_t replayed;
+    StreamAligner<NUMBER_OF_STREAMS> aligner;
+    setup(aligner, replayed);
+    StreamReplayer replayer(LOG);
+    size_t events = replayer.replay(aligner);
+    BOOST_CHECK(replayer.atEnd());
+    BOOST_CHECK_EQUAL(events, replayer.getEvents());
+
+    BOOST_REQUIRE_EQUAL(replayed.size(), recorded.size());
+    for (size_t i = 0; i < recorded.size(); ++i)
+    {
+        BOOST_CHECK(replayed[i].first == recorded[i].first);
+        BOOST_CHECK_EQUAL(replayed[i].second, recorded[i].second);
+    }
+
+    /** deterministic: a second replay gives the same output **/
+    output_t again;
+    StreamAligner<NUMBER_OF_STREAMS> other;
+    setup(other, again);
+    replayer.rewind();
+    BOOST_CHECK_EQUAL(replayer.replay(other), events);
+    BOOST_CHECK(again == replayed);
+
+    other.registerStream<std::vector<int>, N>([](const base::Time &, const std::vector<int> &) {}, base::Time::fromMilliseconds(10));
+    StreamRecorder recorder(LOG);
+    BOOST_CHECK_THROW(other.setRecorder(&recorder), std::runtime_error);
+
+    /** the samples of a concurrent stream are logged when they are
+     * ingested, before the step that releases them **/
+    auto setup_concurrent = [](StreamAligner<NUMBER_OF_STREAMS> &aligner, output_t &output) -> ConcurrentStreamHandle<int, N, N>
+    {
+        aligner.setTimeout(base::Time());
+        ConcurrentStreamHandle<int, N, N> handle = aligner.registerConcurrentStream<int, N, N>([&output](const base::Time &ts, const int &value) { output.push_back(std::make_pair(ts, std::to_string(value))); }, base::Time::fromMilliseconds(10));
+        aligner.registerStream<int, N>([&output](const base::Time &ts, const int &value) { output.push_back(std::make_pair(ts, std::to_string(value))); }, base::Time::fromMilliseconds(10));
+        return handle;
+    };
+
+    output_t concurrent_recorded;
+    {
+        StreamAligner<NUMBER_OF_STREAMS> aligner;
+        ConcurrentStreamHandle<int, N, N> handle = setup_concurrent(aligner, concurrent_recorded);
+        StreamRecorder recorder(LOG);
+        aligner.setRecorder(&recorder);
+
+        for (int i = 0; i < 20; ++i)
+        {
+            BOOST_REQUIRE(aligner.pushConcurrent(handle, base::Time::fromMilliseconds(1000 + 10 * i), i));
+            aligner.push<int, N>(1, base::Time::fromMilliseconds(1005 + 10 * i), 100 + i);
+            if (i % 3 == 0)
+                aligner.step();
+            else if (i % 3 == 1)
+                aligner.stepN(1);
+            else
+                aligner.drain();
+        }
+        aligner.drain();
+    }
+    BOOST_REQUIRE_EQUAL(concurrent_recorded.size(), 40);
+    BOOST_CHECK_EQUAL(concurrent_recorded[0].second, "0");
+    BOOST_CHECK_EQUAL(concurrent_recorded[1].second, "100");
+
+    output_t concurrent_replayed;
+    StreamAligner<NUMBER_OF_STREAMS> concurrent;
+    setup_concurrent(concurrent, concurrent_replayed);
+    StreamReplayer concurrent_replayer(LOG);
+    concurrent_replayer.replay(concurrent);
+    BOOST_CHECK(concurrent_replayed == concurrent_recorded);
+    std::remove(LOG);
+}
+
+BOOST_AUTO_TEST_CASE( latency_histogram_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 33] ***\n";
+    LatencyHistogram histogram;
+    BOOST_CHECK(histogram.percentile(0.5) == base::Time());
+    for (int i = 1; i <= 1000; ++i)
+        histogram.add(base::Time::fromMicroseconds(i));
+
+    BOOST_CHECK_EQUAL(histogram.count(), 1000);
+    BOOST_CHECK_EQUAL(histogram.min().toMicroseconds(), 1);
+    BOOST_CHECK_EQUAL(histogram.max().toMicroseconds(), 1000);
+    BOOST_CHECK_EQUAL(histogram.mean().toMicroseconds(), 500);
+    BOOST_CHECK_EQUAL(histogram.percentile(0.005).toMicroseconds(), 5);
+    /** within the bucket precision, never below the exact value **/
+    int64_t p50 = histogram.percentile(0.5).toMicroseconds();
+    int64_t p99 = histogram.percentile(0.99).toMicroseconds();
+    BOOST_CHECK(p50 >= 500 && p50 <= 500 + 500 / LatencyHistogram::SUB_BUCKETS);
+    BOOST_CHECK(p99 >= 990 && p99 <= 1000);
+    BOOST_CHECK_EQUAL(histogram.percentile(1).toMicroseconds(), 1000);
+
+    /** beyond the limit, the oldest samples are released unmeasured **/
+    BufferLatency bounded(4);
+    for (size_t i = 1; i <= 6; ++i)
+        bounded.pushed(base::Time::now(), i);
+    for (int i = 0; i < 6; ++i)
+        bounded.released(base::Time::now());
+    BOOST_CHECK_EQUAL(bounded.getHistogram().count(), 4);
+
+    StreamAligner<NUMBER_OF_STREAMS> aligner;
+    aligner.setTimeout(base::Time());
+    const size_t N = 8;
+    int s1 = aligner.registerStream<int, N>([](const base::Time &, const int &) {}, base::Time::fromMilliseconds(10));
+    BOOST_CHECK(aligner.getLatencyHistogram(s1) == NULL);
+    aligner.enableLatencyHistogram(s1);
+
+    for (int i = 0; i < 4; ++i)
+        aligner.push<int, N>(s1, base::Time::fromMilliseconds(1000 + 10 * i), i);
+    /** out of order sample, which is released first **/
+    aligner.setReorderWindow(s1, base::Time::fromSeconds(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    aligner.push<int, N>(s1, base::Time::fromMilliseconds(999), -1);
+    aligner.step();
+    const LatencyHistogram *stream_histogram = aligner.getLatencyHistogram(s1);
+    BOOST_REQUIRE(stream_histogram);
+    BOOST_CHECK(stream_histogram->max() < base::Time::fromMilliseconds(10));
+
+    aligner.drain();
+    BOOST_CHECK_EQUAL(stream_histogram->count(), 5);
+    BOOST_CHECK(stream_histogram->max() >= base::Time::fromMilliseconds(20));
+
+    const StreamStatus status = aligner.getBufferStatus(s1);
+    BOOST_CHECK(status.time_in_buffer_p50 >= base::Time::fromMilliseconds(20));
+    BOOST_CHECK(status.time_in_buffer_max == stream_histogram->max());
+
+    aligner.disableLatencyHistogram(s1);
+    BOOST_CHECK(aligner.getLatencyHistogram(s1) == NULL);
+}
+
+BOOST_AUTO_TEST_CASE( status_publisher_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 34] ***\n";
+    StatusPublisher<NUMBER_OF_STREAMS> publisher;
+    StatusSnapshot<NUMBER_OF_STREAMS> snapshot;
+    publisher.read(snapshot);
+    BOOST_CHECK_EQUAL(snapshot.publications, 0);
+    BOOST_CHECK_EQUAL(snapshot.stream_count, 0);
+
+    StreamAligner<NUMBER_OF_STREAMS> aligner;
+    aligner.setTimeout(base::Time());
+    const size_t N = 8;
+    int s1 = aligner.registerStream<int, N>([](const base::Time &, const int &) {}, base::Time::fromMilliseconds(10), 0, "imu");
+    aligner.setStatusPublisher(&publisher);
+    int s2 = aligner.registerStream<int, N>([](const base::Time &, const int &) {}, base::Time::fromMilliseconds(10), 1, "camera");
+    aligner.publishStatus();
+
+    publisher.read(snapshot);
+    BOOST_CHECK_EQUAL(snapshot.publications, 1);
+    BOOST_CHECK_EQUAL(snapshot.stream_count, NUMBER_OF_STREAMS);
+    BOOST_CHECK_EQUAL(std::string(snapshot.streams[s1].name), "imu");
+    BOOST_CHECK_EQUAL(std::string(snapshot.streams[s2].name), "camera");
+    BOOST_CHECK_EQUAL(snapshot.streams[s2].priority, 1);
+    BOOST_CHECK(snapshot.streams[s1].active);
+    BOOST_CHECK(!snapshot.streams[s2 + 1].active);
+    /** the names are copied once, at registration **/
+    const char *name = snapshot.streams[s1].name;
+
+    /** a monitoring thread reads while the aligner runs **/
+    std::atomic<bool> done(false);
+    bool consistent = true;
+    std::thread monitor([&]()
+    {
+        StatusSnapshot<NUMBER_OF_STREAMS> reading;
+        uint64_t publications = 0;
+        while (!done.load())
+        {
+            publisher.read(reading);
+            const StreamSnapshot &stream(reading.streams[s1]);
+            consistent = consistent && reading.publications >= publications
+                && stream.name == name
+                && stream.samples_received == stream.samples_processed + stream.buffer_fill + stream.samples_dropped_buffer_full;
+            publications = reading.publications;
+        }
+    });
+
+    const int samples = 20000;
+    for (int i = 0; i < samples; ++i)
+    {
+        aligner.push<int, N>(s1, base::Time::fromMicroseconds(1000000 + i * 10000), i);
+        if (i % 3 == 0)
+            aligner.step();
+        aligner.publishStatus();
+    }
+    aligner.drain();
+    aligner.publishStatus();
+    done.store(true);
+    monitor.join();
+    BOOST_CHECK(consistent);
+
+    publisher.read(snapshot);
+    BOOST_CHECK_EQUAL(snapshot.publications, samples + 2);
+    BOOST_CHECK_EQUAL(snapshot.streams[s1].samples_received, samples);
+    BOOST_CHECK_EQUAL(snapshot.streams[s1].samples_processed + snapshot.streams[s1].samples_dropped_buffer_full, samples);
+    BOOST_CHECK(snapshot.current_time == aligner.getCurrentTime());
+
+    /** streams past the capacity of a dynamic aligner's publisher are not
+     * published **/
+    DynamicStreamAligner dynamic;
+    StatusPublisher<0> small(1);
+    dynamic.setStatusPublisher(&small);
+    dynamic.registerStream<int, N>([](const base::Time &, const int &) {}, base::Time::fromMilliseconds(10), 0, "first");
+    dynamic.registerStream<int, N>([](const base::Time &, const int &) {}, base::Time::fromMilliseconds(10), 0, "second");
+    dynamic.publishStatus();
+    StatusSnapshot<0> dynamic_snapshot;
+    small.read(dynamic_snapshot);
+    BOOST_CHECK_EQUAL(dynamic_snapshot.stream_count, 1);
+    BOOST_CHECK_EQUAL(std::string(dynamic_snapshot.streams[0].name), "first");
+}
+
+BOOST_AUTO_TEST_CASE( static_stream_aligner_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 35] ***\n";
+    typedef std::pair<int, base::Time> Release;
+    std::vector<Release> expected, released;
+
+    StreamAligner<NUMBER_OF_STREAMS> aligner(base::Time::fromMilliseconds(20));
+    int s1 = aligner.registerStream<int, 8>([&expected](const base::Time &ts, const int &) { expected.push_back(Release(0, ts)); }, base::Time::fromMilliseconds(10), 1);
+    int s2 = aligner.registerStream<std::string, 4>([&expected](const base::Time &ts, const std::string &) { expected.push_back(Release(1, ts)); }, base::Time::fromMilliseconds(15), 0);
+
+    StaticStreamAligner< StreamSpec<int, 8>, StreamSpec<std::string, 4> > static_aligner(base::Time::fromMilliseconds(20));
+    BOOST_CHECK_THROW(static_aligner.push<0>(base::Time::fromMilliseconds(1000), 0), std::runtime_error);
+    static_aligner.registerStream<0>([&released](const base::Time &ts, const int &) { released.push_back(Release(0, ts)); }, base::Time::fromMilliseconds(10), 1);
+    static_aligner.registerStream<1>([&released](const base::Time &ts, const std::string &) { released.push_back(Release(1, ts)); }, base::Time::fromMilliseconds(15), 0);
+    BOOST_CHECK_THROW(static_aligner.registerStream<1>(NULL, base::Time(), 0), std::runtime_error);
+
+    /** same input: interleaved streams, a gap on the second one, equal
+     * timestamps, a late sample and a stream disabled for a while **/
+    for (int i = 0; i < 60; ++i)
+    {
+        base::Time ts = base::Time::fromMilliseconds(1000 + 10 * i);
+        aligner.push<int, 8>(s1, ts, i);
+        static_aligner.push<0>(ts, i);
+        if (i % 3 == 0 && (i < 20 || i > 35))
+        {
+            aligner.push<std::string, 4>(s2, ts, std::string("sample"));
+            static_aligner.emplace<1>(ts, "sample");
+        }
+        if (i == 45)
+        {
+            aligner.push<std::string, 4>(s2, base::Time::fromMilliseconds(1000), std::string("late"));
+            static_aligner.push<1>(base::Time::fromMilliseconds(1000), std::string("late"));
+            aligner.disableStream(s2);
+            static_aligner.disableStream<1>();
+        }
+        if (i % 2)
+        {
+            aligner.step();
+            static_aligner.step();
+        }
+        else
+        {
+            aligner.stepN(2);
+            static_aligner.stepN(2);
+        }
+        BOOST_REQUIRE_EQUAL(released.size(), expected.size());
+    }
+    aligner.drain();
+    static_aligner.drain();
+
+    BOOST_REQUIRE_EQUAL(released.size(), expected.size());
+    BOOST_CHECK(released.size() > 60);
+    for (size_t i = 0; i < released.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(released[i].first, expected[i].first);
+        BOOST_CHECK(released[i].second == expected[i].second);
+    }
+    BOOST_CHECK(static_aligner.getCurrentTime() == aligner.getCurrentTime());
+    BOOST_CHECK_EQUAL(static_aligner.getBufferStatus<0>().samples_processed, aligner.getBufferStatus(s1).samples_processed);
+    BOOST_CHECK_EQUAL(static_aligner.getBufferStatus<1>().samples_dropped_late_arriving, 1);
+    BOOST_CHECK_EQUAL(static_aligner.getSamplesDroppedLateArriving(), 1);
+
+    static_aligner.clear();
+    BOOST_CHECK(static_aligner.getCurrentTime() == base::Time());
+    static_aligner.unregisterStream<1>();
+    BOOST_CHECK(!static_aligner.isRegistered<1>());
+}
+
+BOOST_AUTO_TEST_CASE( buffer_size_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 36] ***\n";
+    /** 10 ms period, 95 ms timeout: 10 samples, 20 with the default margin **/
+    static_assert(samplesInTimeout(10000, 95000) == 10, "samples in timeout");
+    static_assert(bufferSize(10000, 95000) == 20, "default buffer size");
+    static_assert(bufferSize(-10000, 95000, 150) == 15, "negative period");
+    static_assert(bufferSize(0, 95000) == 0, "aperiodic stream");
+    static_assert(bufferSizeFits(10, 10000, 95000) && !bufferSizeFits(9, 10000, 95000), "buffer size check");
+
+    typedef SizedStreamSpec<int, 10000, 95000> Fast;
+    static_assert(Fast::buffer_size == 20, "sized stream spec");
+
+    StreamAligner<NUMBER_OF_STREAMS> aligner(Fast::timeout());
+    int s1 = aligner.registerStream<Fast::value_type, Fast::buffer_size>(NULL, Fast::period());
+    int s2 = aligner.registerStream<int, 4>(NULL, base::Time::fromMilliseconds(40), 0, "slow");
+    aligner.registerStream<int, 1>(NULL, base::Time(), 0, "aperiodic");
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(s1).buffer_size_required, 10);
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(s2).buffer_size_required, 3);
+    aligner.checkBufferSizes();
+
+    /** a longer timeout makes the buffer of the slow stream too small **/
+    aligner.setTimeout(base::Time::fromMilliseconds(160));
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(s2).buffer_size_required, 5);
+    BOOST_CHECK_THROW(aligner.checkBufferSizes(), std::runtime_error);
+
+    /** unless it can grow **/
+    aligner.setBufferPool(1024, 16);
+    aligner.enableBufferGrowth(s2);
+    aligner.checkBufferSizes();
+
+    StaticStreamAligner< Fast, StreamSpec<int, 4> > static_aligner(Fast::timeout());
+    static_aligner.registerStream<0>(NULL, Fast::period());
+    static_aligner.registerStream<1>(NULL, base::Time::fromMilliseconds(40));
+    static_aligner.checkBufferSizes();
+    static_aligner.setTimeout(base::Time::fromMilliseconds(160));
+    BOOST_CHECK_THROW(static_aligner.checkBufferSizes(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE( stream_selector_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 37] ***\n";
+    /** enough blocks of streams for the vectorized scans **/
+    const size_t N = 601;
+    StreamSelector<N> selector;
+    StreamSelector<0> dynamic_selector;
+    dynamic_selector.resize(N / 3);
+    BOOST_CHECK_EQUAL(selector.nextData(), -1);
+    BOOST_CHECK_EQUAL(selector.nextWaitingTime(), StreamSelector<N>::NONE);
+
+    /** reference: state, time and priority of each stream **/
+    int states[N] = { 0 };
+    int64_t times[N];
+    int priorities[N];
+
+    srand(42);
+    for (int round = 0; round < 20000; ++round)
+    {
+        /** the dynamic selector grows halfway **/
+        if (round == 10000)
+            dynamic_selector.resize(N);
+        int idx = rand() % (round < 10000 ? N / 3 : N);
+        int64_t time = 1000 + rand() % 50;
+        int priority = rand() % 3 - 1;
+        switch (rand() % 3)
+        {
+            case 0:
+                selector.setData(idx, time, priority);
+                dynamic_selector.setData(idx, time, priority);
+                states[idx] = 1;
+                break;
+            case 1:
+                selector.setWaiting(idx, time, priority);
+                dynamic_selector.setWaiting(idx, time, priority);
+                states[idx] = 2;
+                break;
+            default:
+                selector.remove(idx);
+                dynamic_selector.remove(idx);
+                states[idx] = 0;
+        }
+        times[idx] = time;
+        priorities[idx] = priority;
+
+        int next = -1;
+        int64_t waiting = StreamSelector<N>::NONE;
+        for (size_t i = 0; i < N; ++i)
+        {
+            if (states[i] == 1 && (next == -1 || times[i] < times[next] ||
+                        (times[i] == times[next] && priorities[i] < priorities[next])))
+                next = i;
+            if (states[i] == 2 && times[i] < waiting)
+                waiting = times[i];
+        }
+
+        BOOST_REQUIRE_EQUAL(selector.nextData(), next);
+        BOOST_REQUIRE_EQUAL(dynamic_selector.nextData(), next);
+        BOOST_REQUIRE_EQUAL(selector.nextWaitingTime(), waiting);
+        BOOST_REQUIRE_EQUAL(dynamic_selector.nextWaitingTime(), waiting);
+        if (next != -1)
+            BOOST_REQUIRE_EQUAL(selector.dataTime(next), times[next]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( ticks_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 38] ***\n";
+    BOOST_CHECK_EQUAL(toTicks(base::Time::fromMilliseconds(3)), 3000);
+    BOOST_CHECK_EQUAL(fromTicks(-2500).toMicroseconds(), -2500);
+
+    /** times given to the aligner come back unchanged through its interface **/
+    StreamAligner<NUMBER_OF_STREAMS> aligner(base::Time::fromMicroseconds(250));
+    BOOST_CHECK_EQUAL(aligner.getTimeOut().toMicroseconds(), 250);
+
+    std::vector<int64_t> released;
+    int s1 = aligner.registerStream<int, 4>([&released](const base::Time &ts, const int &){ released.push_back(ts.toMicroseconds()); },
+            base::Time::fromMicroseconds(100), 0, "s1");
+    int s2 = aligner.registerStream<int, 4>(NULL, base::Time::fromMicroseconds(200), 0, "s2");
+    int s3 = aligner.registerStream<int, 4>(NULL, base::Time::fromMicroseconds(-100), 0, "s3");
+    aligner.disableStream(s3);
+    aligner.setReorderWindow(s1, base::Time::fromMicroseconds(50));
+    aligner.setRateLimit(s2, base::Time::fromMicroseconds(100));
+    StreamHandle<int, 4> h1 = aligner.getStreamHandle<int, 4>(s1), h3 = aligner.getStreamHandle<int, 4>(s3);
+    BOOST_CHECK_EQUAL(h1.stream->getReorderWindow().toMicroseconds(), 50);
+    BOOST_CHECK_EQUAL(h3.stream->getPeriod().toMicroseconds(), -100);
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(s1).buffer_size_required, 3);
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(s3).buffer_size_required, 3);
+
+    aligner.push<int, 4>(s1, base::Time::fromMicroseconds(1100), 1);
+    aligner.push<int, 4>(s1, base::Time::fromMicroseconds(1060), 2);
+    aligner.push<int, 4>(s1, base::Time::fromMicroseconds(1000), 3);
+    aligner.push<int, 4>(s2, base::Time::fromMicroseconds(1050), 4);
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(s1).samples_reordered, 1);
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(s1).samples_backward_in_time, 1);
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(s1).earliest_data_time.toMicroseconds(), 1060);
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(s1).latest_data_time.toMicroseconds(), 1100);
+
+    BOOST_CHECK_EQUAL(aligner.stepUntil(base::Time::fromMicroseconds(1060)), 2);
+    BOOST_CHECK_EQUAL(aligner.getCurrentTime().toMicroseconds(), 1060);
+    BOOST_CHECK_EQUAL(aligner.getLatency().toMicroseconds(), 40);
+    aligner.drain();
+    BOOST_CHECK_EQUAL(aligner.getCurrentTime().toMicroseconds(), 1100);
+    BOOST_CHECK(aligner.nextReleaseTime() == base::Time::max());
+    BOOST_CHECK_EQUAL(released.size(), 2);
+
+    /** the rate limit of s2 drops the next sample, s1 then waits for s2
+     * up to the timeout **/
+    aligner.push<int, 4>(s2, base::Time::fromMicroseconds(1105), 5);
+    aligner.push<int, 4>(s1, base::Time::fromMicroseconds(1300), 6);
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(s2).samples_dropped_decimation, 1);
+    BOOST_CHECK_EQUAL(aligner.nextReleaseTime().toMicroseconds(), 1350);
+    BOOST_CHECK(!aligner.step());
+    aligner.advanceTime(base::Time::fromMicroseconds(1400));
+    BOOST_CHECK_EQUAL(aligner.getLatestTime().toMicroseconds(), 1400);
+    BOOST_CHECK(aligner.step());
+    BOOST_CHECK_EQUAL(released.back(), 1300);
+}
+
+BOOST_AUTO_TEST_CASE( split_timestamp_storage_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 39] ***\n";
+    /** kilobyte samples carrying their own time, reordered within the
+     * buffer and across the overflow **/
+    typedef std::array<int64_t, 128> Payload;
+    std::vector<int64_t> released;
+    bool consistent = true;
+
+    /** the status read from the callback still sees the released sample
+     * with its time **/
+    StreamAligner<NUMBER_OF_STREAMS> aligner(base::Time::fromSeconds(2));
+    aligner.setBufferPool(4096, 8);
+    StreamHandle<Payload, 4> handle = aligner.registerStreamHandle<Payload, 4>(
+        [&released, &consistent, &aligner](const base::Time &ts, const Payload &value)
+        {
+            released.push_back(ts.toMicroseconds());
+            consistent = consistent && value[0] == ts.toMicroseconds() && value[127] == -ts.toMicroseconds();
+            consistent = consistent && aligner.getBufferStatus(0).earliest_data_time == ts;
+        }, base::Time::fromMicroseconds(10), 0, "payload");
+    aligner.enableBufferGrowth(handle);
+    aligner.setReorderWindow(handle, base::Time::fromMicroseconds(100));
+
+    const int64_t times[] = { 10, 30, 20, 50, 60, 40, 70, 15, 80, 25, 90 };
+    for (size_t i = 0; i < sizeof(times) / sizeof(times[0]); ++i)
+    {
+        Payload value;
+        value.fill(0);
+        value[0] = times[i];
+        value[127] = -times[i];
+        aligner.push(handle, base::Time::fromMicroseconds(times[i]), value);
+    }
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(handle).samples_reordered, 4);
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(handle).buffer_fill, 11);
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(handle).earliest_data_time.toMicroseconds(), 10);
+
+    base::Time ts;
+    const Payload *next = aligner.peekNextSample(handle, ts);
+    BOOST_REQUIRE(next);
+    BOOST_CHECK_EQUAL(ts.toMicroseconds(), 10);
+    BOOST_CHECK_EQUAL((*next)[0], 10);
+
+    aligner.drain();
+    BOOST_CHECK(consistent);
+    BOOST_REQUIRE_EQUAL(released.size(), 11);
+    BOOST_CHECK(std::is_sorted(released.begin(), released.end()));
+    BOOST_CHECK_EQUAL(released.front(), 10);
+    BOOST_CHECK_EQUAL(released.back(), 90);
+}
+
+BOOST_AUTO_TEST_CASE( buffer_pool_reconfigure_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 40] ***\n";
+    StreamAligner<NUMBER_OF_STREAMS> aligner;
+    aligner.setTimeout(base::Time::fromSeconds(1000.0));
+
+    /** growth enabled with the default pool, whose chunks get smaller
+     * before any sample overflows **/
+    std::vector<int> played;
+    int s1 = aligner.registerStream<int, 4>(
+            [&played](const base::Time &, const int &value) { played.push_back(value); },
+            base::Time::fromSeconds(0));
+    int s2 = aligner.registerStream<int, 4>(nullptr, base::Time::fromSeconds(1));
+    aligner.enableBufferGrowth(s1);
+    aligner.setBufferPool(64, 16);
+
+    /** 4 samples in the buffer, 3 per chunk in the overflow **/
+    for (int i = 0; i < 200; ++i)
+        aligner.push<int, 4>(s1, base::Time::fromSeconds(2.0 + i), i);
+
+    StreamStatus status = aligner.getBufferStatus(s1);
+    BOOST_CHECK_EQUAL(status.buffer_fill, 4 + 16 * 3);
+    BOOST_CHECK_EQUAL(status.samples_dropped_buffer_full, 200 - 4 - 16 * 3);
+    BOOST_CHECK_EQUAL(aligner.getBufferPool().chunksUsed(), 16);
+
+    aligner.disableStream(s2);
+    BOOST_CHECK_EQUAL(aligner.drain(), 4 + 16 * 3);
+    BOOST_REQUIRE_EQUAL(played.size(), 4 + 16 * 3);
+    for (int i = 0; i < 4 + 16 * 3; ++i)
+        BOOST_CHECK_EQUAL(played[i], i);
+}
+
+BOOST_AUTO_TEST_CASE( serialized_size_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 41] ***\n";
+    StreamAligner<NUMBER_OF_STREAMS> aligner;
+    aligner.setTimeout(base::Time::fromSeconds(1.0));
+
+    std::vector<double> played;
+    int s1 = aligner.registerStream<double, 4>(
+            [&played](const base::Time &, const double &value) { played.push_back(value); },
+            base::Time::fromSeconds(0));
+
+    char record[sizeof(double)];
+    const double value = 1.5;
+    std::memcpy(record, &value, sizeof(double));
+
+    /** a truncated or mismatched record from a log is not read **/
+    BOOST_CHECK_THROW(aligner.pushSerialized(s1, base::Time::fromSeconds(1.0), record, sizeof(double) - 1), std::runtime_error);
+    BOOST_CHECK_THROW(aligner.pushSerialized(s1, base::Time::fromSeconds(1.0), record, sizeof(double) + 1), std::runtime_error);
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(s1).buffer_fill, 0);
+
+    aligner.pushSerialized(s1, base::Time::fromSeconds(1.0), record, sizeof(double));
+    BOOST_CHECK_EQUAL(aligner.drain(), 1);
+    BOOST_REQUIRE_EQUAL(played.size(), 1);
+    BOOST_CHECK_EQUAL(played[0], value);
+}
+
+BOOST_AUTO_TEST_CASE( async_aligner_data_time_test )
+{
+    std::cout<<"\n*** STREAM_ALIGNER [TEST 42] ***\n";
+    AsyncStreamAligner<NUMBER_OF_STREAMS> aligner(base::Time::fromMilliseconds(100));
+
+    std::mutex played_mutex;
+    std::vector<int> played;
+    auto callback = [&](const base::Time &, const int &value)
+    {
+        std::lock_guard<std::mutex> lock(played_mutex);
+        played.push_back(value);
+    };
+    auto wait_played = [&](size_t count)
+    {
+        base::Time end = base::Time::now() + base::Time::fromSeconds(5);
+        while(base::Time::now() < end)
+        {
+            {
+                std::lock_guard<std::mutex> lock(played_mutex);
+                if(played.size() >= count)
+                    return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    };
+
+    /** timestamps of a simulation, far from the wall clock **/
+    const size_t N = 4;
+    int s1 = aligner.registerStream<int, N>(callback, base::Time::fromMilliseconds(10));
+    int s2 = aligner.registerStream<int, N>(callback, base::Time::fromMilliseconds(10));
+    aligner.start();
+
+    base::Time t0 = base::Time::fromSeconds(1000.0);
+    base::Time started = base::Time::now();
+    aligner.push<int, N>(s1, t0, 1);
+    aligner.push<int, N>(s2, t0, 2);
+    aligner.push<int, N>(s1, t0 + base::Time::fromMilliseconds(20), 3);
+
+    /** s2 times out once the data time, going on at the pace of the wall
+     * clock from t0 + 20ms, reaches t0 + 100ms **/
+    BOOST_REQUIRE(wait_played(3));
+    BOOST_CHECK(!(base::Time::now() < started + base::Time::fromMilliseconds(80)));
+
+    /** the data time stays in the time base of the samples **/
+    BOOST_CHECK(aligner.getLatestTime() < t0 + base::Time::fromSeconds(1.0));
+    BOOST_CHECK(aligner.getCurrentTime() == t0 + base::Time::fromMilliseconds(20));
+
+    /** and the next samples are not late **/
+    aligner.push<int, N>(s1, t0 + base::Time::fromMilliseconds(30), 4);
+    aligner.push<int, N>(s2, t0 + base::Time::fromMilliseconds(30), 5);
+    BOOST_REQUIRE(wait_played(5));
+
+    aligner.stop();
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(s1).samples_dropped_late_arriving, 0);
+    BOOST_CHECK_EQUAL(aligner.getBufferStatus(s2).samples_dropped_late_arriving, 0);
+}